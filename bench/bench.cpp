@@ -0,0 +1,259 @@
+/**
+ * Benchmarks of the library, timed by time.h.
+ *
+ * Build with -DCMAKE_BUILD_TYPE=Release and run escapist_bench, optionally with the name of
+ * a single group. Every case is run once to warm up, then a fixed amount of times, each run
+ * timed by a ScopedTimer into a LatencyHistogram. The mean, median and 99th percentile of
+ * a run are printed in nanoseconds.
+ */
+
+#include "../escapist/list.h"
+#include "../escapist/string.h"
+#include "../escapist/time.h"
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+    volatile SizeType sink; // keeps the results alive, so that the measured work is not optimized away.
+
+    void Keep(SizeType value) {
+        sink = sink + value;
+    }
+
+    template<typename Function>
+    void Run(const char *name, SizeType repeats, Function function) {
+        LatencyHistogram histogram;
+        function();
+        for (SizeType i = 0; i < repeats; ++i) {
+            ScopedTimer timer(histogram);
+            function();
+        }
+        std::printf("  %-64s %12.0f %12llu %12llu\n", name, histogram.Mean(),
+                    static_cast<unsigned long long>(histogram.Percentile(0.5)),
+                    static_cast<unsigned long long>(histogram.Percentile(0.99)));
+    }
+
+    void Group(const char *name) {
+        std::printf("%s\n  %-64s %12s %12s %12s\n", name, "case", "mean", "p50", "p99");
+    }
+
+    const char *PolicyName(MultiThreadPolicy) {
+        return "MultiThreadPolicy";
+    }
+
+    const char *PolicyName(SingleThreadPolicy) {
+        return "SingleThreadPolicy";
+    }
+
+    const char *PolicyName(UnsharedPolicy) {
+        return "UnsharedPolicy";
+    }
+
+    /**
+     * Copy-heavy workloads, where the thread policy decides between an atomic count,
+     * a plain count and a deep copy.
+     */
+    template<typename Thread>
+    void ThreadPolicyCases() {
+        using IntList = List<int, MallocAllocator, HalfGrowth, Thread>;
+        using String = BasicString<char, Thread>;
+        const SizeType kCopies = 1000;
+        char name[96];
+
+        IntList list;
+        for (int i = 0; i < 1024; ++i) {
+            list.Append(i);
+        }
+        std::snprintf(name, sizeof(name), "%s: 1000 copies of a 1K-int List", PolicyName(Thread()));
+        Run(name, 200, [&] {
+            for (SizeType i = 0; i < kCopies; ++i) {
+                IntList copy(list);
+                Keep(copy.Count());
+            }
+        });
+
+        std::snprintf(name, sizeof(name), "%s: 1000 copies of a 1K-int List, then a write", PolicyName(Thread()));
+        Run(name, 200, [&] {
+            for (SizeType i = 0; i < kCopies; ++i) {
+                IntList copy(list);
+                copy.SetAt(0, int(i));
+                Keep(copy.Count());
+            }
+        });
+
+        String str("a string long enough to be kept in a heap block of its own");
+        std::snprintf(name, sizeof(name), "%s: 1000 copies of a 59-char String", PolicyName(Thread()));
+        Run(name, 200, [&] {
+            for (SizeType i = 0; i < kCopies; ++i) {
+                String copy(str);
+                Keep(copy.Length());
+            }
+        });
+    }
+
+    /**
+     * Four threads copying one List at once, only for the policies which allow it.
+     */
+    template<typename Thread>
+    void ContendedCopyCase() {
+        using IntList = List<int, MallocAllocator, HalfGrowth, Thread>;
+        IntList list;
+        for (int i = 0; i < 1024; ++i) {
+            list.Append(i);
+        }
+        char name[96];
+        std::snprintf(name, sizeof(name), "%s: 4 threads x 1000 copies of a 1K-int List", PolicyName(Thread()));
+        Run(name, 50, [&] {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&list] {
+                    for (SizeType i = 0; i < 1000; ++i) {
+                        IntList copy(list);
+                        Keep(copy.Count());
+                    }
+                });
+            }
+            for (std::thread &thread: threads) {
+                thread.join();
+            }
+        });
+    }
+
+    void ThreadPolicyGroup() {
+        Group("thread_policy");
+        ThreadPolicyCases<MultiThreadPolicy>();
+        ThreadPolicyCases<SingleThreadPolicy>();
+        ThreadPolicyCases<UnsharedPolicy>();
+        ContendedCopyCase<MultiThreadPolicy>();
+        ContendedCopyCase<UnsharedPolicy>();
+    }
+
+    /**
+     * @return \p len pseudo-random characters in [a, p], followed by \p tail
+     */
+    BasicString<char> Text(SizeType len, const BasicString<char> &tail) {
+        std::vector<char> text(len + 1, '\0');
+        unsigned state = 12345;
+        for (SizeType i = 0; i < len; ++i) {
+            state = state * 1103515245 + 12345;
+            text[i] = char('a' + (state >> 16) % 16);
+        }
+        ::memcpy(text.data() + len - tail.Length(), tail.ConstData(), tail.Length());
+        return BasicString<char>(text.data(), len);
+    }
+
+    /**
+     * Compare and search through the explicit lengths of BasicString against the
+     * null-terminated routines, which rescan for the terminator.
+     */
+    void StringSearchGroup() {
+        Group("string_search");
+        const SizeType sizes[] = {1 << 10, 1 << 14, 1 << 18, 1 << 20};
+        BasicString<char> short_needle("zqzqzqzqzqzqzqzq"), long_needle(Text(300, BasicString<char>("z")));
+        char name[96];
+        for (SizeType size: sizes) {
+            BasicString<char> left(Text(size, short_needle)), right(Text(size, short_needle));
+            BasicString<char> haystack(Text(size, long_needle));
+            const char *left_data = left.ConstData(), *right_data = right.ConstData();
+            const char *haystack_data = haystack.ConstData();
+
+            std::snprintf(name, sizeof(name), "%7u B: compare equal, null-terminated", unsigned(size));
+            Run(name, 200, [&] { Keep(SizeType(ICharTrait<char>::Compare(left_data, right_data) + 1)); });
+            std::snprintf(name, sizeof(name), "%7u B: compare equal, explicit length", unsigned(size));
+            Run(name, 200, [&] { Keep(SizeType(left.CompareTo(right) + 1)); });
+
+            std::snprintf(name, sizeof(name), "%7u B: find a character at the end, null-terminated", unsigned(size));
+            Run(name, 200, [&] { Keep(SizeType(ICharTrait<char>::Find(left_data, 'z') - left_data)); });
+            std::snprintf(name, sizeof(name), "%7u B: find a character at the end, explicit length", unsigned(size));
+            Run(name, 200, [&] { Keep(left.IndexOf('z')); });
+
+            std::snprintf(name, sizeof(name), "%7u B: find 16 chars at the end, null-terminated", unsigned(size));
+            Run(name, 200, [&] {
+                Keep(SizeType(ICharTrait<char>::Find(left_data, short_needle.ConstData()) - left_data));
+            });
+            std::snprintf(name, sizeof(name), "%7u B: find 16 chars at the end, explicit length", unsigned(size));
+            Run(name, 200, [&] { Keep(left.IndexOf(short_needle)); });
+
+            std::snprintf(name, sizeof(name), "%7u B: find 300 chars at the end, null-terminated", unsigned(size));
+            Run(name, 200, [&] {
+                Keep(SizeType(ICharTrait<char>::Find(haystack_data, long_needle.ConstData()) - haystack_data));
+            });
+            std::snprintf(name, sizeof(name), "%7u B: find 300 chars at the end, explicit length", unsigned(size));
+            Run(name, 200, [&] { Keep(haystack.IndexOf(long_needle)); });
+        }
+    }
+
+    /**
+     * Summing a List through the plain pointers of begin() and end() against the iterators before them.
+     */
+    void IteratorGroup() {
+        Group("iterator");
+        const SizeType sizes[] = {1 << 10, 1 << 20};
+        char name[96];
+        for (SizeType size: sizes) {
+            List<int> list;
+            for (SizeType i = 0; i < size; ++i) {
+                list.Append(int(i));
+            }
+            const List<int> &view = list;
+            SizeType repeats = size > 100000 ? 50 : 2000;
+
+            std::snprintf(name, sizeof(name), "%7u ints: range-for over begin() and end()", unsigned(size));
+            Run(name, repeats, [&] {
+                SizeType sum = 0;
+                for (int value: view) {
+                    sum += value;
+                }
+                Keep(sum);
+            });
+
+            std::snprintf(name, sizeof(name), "%7u ints: CheckedPointer, as in debug builds", unsigned(size));
+            Run(name, repeats, [&] {
+                const int *first = view.ConstData(), *last = first + view.Count();
+                SizeType sum = 0;
+                for (Internal::CheckedPointer<const int> it(first, first, last), end(last, first, last);
+                     it != end; ++it) {
+                    sum += *it;
+                }
+                Keep(sum);
+            });
+
+            std::snprintf(name, sizeof(name), "%7u ints: ConstIterator, HaveNext and Next", unsigned(size));
+            Run(name, repeats, [&] {
+                SizeType sum = 0;
+                for (List<int>::ConstIterator it = view.ConstIteratorAt(0); it.HaveNext(); it = it.Next()) {
+                    sum += it.Instance();
+                }
+                Keep(sum);
+            });
+
+            std::snprintf(name, sizeof(name), "%7u ints: ConstAt by index", unsigned(size));
+            Run(name, repeats, [&] {
+                SizeType sum = 0;
+                for (SizeType i = 0; i < size; ++i) {
+                    sum += view.ConstAt(i);
+                }
+                Keep(sum);
+            });
+        }
+    }
+
+    bool Selected(int argc, char **argv, const char *group) {
+        return argc < 2 || !std::strcmp(argv[1], group);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (Selected(argc, argv, "thread_policy")) {
+        ThreadPolicyGroup();
+    }
+    if (Selected(argc, argv, "string_search")) {
+        StringSearchGroup();
+    }
+    if (Selected(argc, argv, "iterator")) {
+        IteratorGroup();
+    }
+    return 0;
+}
@@ -0,0 +1,326 @@
+/**
+ * Allocation policies for the containers in this library.
+ *
+ * Every container that owns a heap block asks one of these policies for its
+ * memory instead of calling ::malloc/::realloc/::free directly. A policy is
+ * a struct of static functions (just like TypeTrait), so it costs nothing to
+ * carry around and the container layout does not change:
+ *  - Allocate(size): returns at least \p size bytes, suitably aligned.
+ *  - Reallocate(ptr, old_size, new_size): grows or shrinks the block, keeping
+ *    the first min(old_size, new_size) bytes.
+ *  - Free(ptr, size): returns the block.
+ *
+ * Three policies are provided:
+ *  - MallocAllocator: the C heap, the default.
+ *  - ArenaAllocator<Tag>: a bump-pointer arena; Free is (almost) a no-op and
+ *    Reset() releases everything allocated so far in one shot.
+ *  - PoolAllocator<Tag>: power-of-two size classes with free lists, so short
+ *    lived blocks of similar sizes are recycled without touching malloc.
+ *
+ * The arena and the pool keep their state per thread and per \c Tag, thus
+ * different request scopes can use different tags. Memory obtained on one
+ * thread must be released on the same thread.
+ */
+
+#ifndef ESCAPIST_ALLOCATOR_H
+#define ESCAPIST_ALLOCATOR_H
+
+#include "base.h"
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * The default policy, forwarding to the C heap.
+ */
+struct MallocAllocator {
+    static inline void *Allocate(SizeType size) {
+        return ::malloc(size);
+    }
+
+    static inline void *Reallocate(void *ptr, SizeType /*old_size*/, SizeType new_size) {
+        return ::realloc(ptr, new_size);
+    }
+
+    static inline void Free(void *ptr, SizeType /*size*/) {
+        ::free(ptr);
+    }
+};
+
+namespace Internal {
+    /**
+     * Rounds \p size up to the alignment every allocator in this file guarantees.
+     */
+    static constexpr SizeType kAllocAlign = alignof(std::max_align_t);
+
+    static constexpr SizeType AlignUp(SizeType size) {
+        return (size + kAllocAlign - 1) & ~(kAllocAlign - 1);
+    }
+}
+
+/**
+ * Bump-pointer arena.
+ * Allocate() only moves a pointer forward inside the current chunk. A new chunk,
+ * at least twice as large as the previous one, is obtained from the C heap when
+ * the current one is exhausted.
+ * Free() and Reallocate() can only give back or extend the most recent block;
+ * anything else stays in the arena until Reset().
+ *
+ * Reset() does not run destructors. Containers of non-trivial elements must be
+ * destroyed before the reset, containers of Pod elements can simply be dropped.
+ * @tparam Tag distinguishes independent arenas.
+ */
+template<typename Tag = void>
+class ArenaAllocator {
+public:
+    static void *Allocate(SizeType size) {
+        State &state = ArenaAllocator::Current();
+        size = Internal::AlignUp(size);
+        if (SizeType(state.end_ - state.pos_) < size) {
+            ArenaAllocator::Grow(state, size);
+        }
+        void *rtn = state.pos_;
+        state.pos_ += size;
+        return rtn;
+    }
+
+    static void *Reallocate(void *ptr, SizeType old_size, SizeType new_size) {
+        if (!ptr) {
+            return ArenaAllocator::Allocate(new_size);
+        }
+        State &state = ArenaAllocator::Current();
+        old_size = Internal::AlignUp(old_size);
+        new_size = Internal::AlignUp(new_size);
+        unsigned char *block = static_cast<unsigned char *>(ptr);
+        if (block + old_size == state.pos_ && SizeType(state.end_ - block) >= new_size) {
+            state.pos_ = block + new_size; // the most recent block, grow or shrink in place.
+            return ptr;
+        }
+        if (new_size <= old_size) {
+            return ptr;
+        }
+        void *rtn = ArenaAllocator::Allocate(new_size);
+        ::memcpy(rtn, ptr, old_size);
+        return rtn;
+    }
+
+    static void Free(void *ptr, SizeType size) {
+        State &state = ArenaAllocator::Current();
+        unsigned char *block = static_cast<unsigned char *>(ptr);
+        if (block && block + Internal::AlignUp(size) == state.pos_) {
+            state.pos_ = block;
+        }
+    }
+
+    /**
+     * Invalidates every block allocated from this arena on the current thread.
+     * The largest chunk is kept for the next round, the others go back to the C heap.
+     */
+    static void Reset() {
+        State &state = ArenaAllocator::Current();
+        if (state.head_) {
+            ArenaAllocator::FreeChunks(state.head_->next_);
+            state.head_->next_ = nullptr;
+            state.pos_ = reinterpret_cast<unsigned char *>(state.head_) + kHeader;
+        }
+    }
+
+    /**
+     * Invalidates every block and returns all chunks to the C heap.
+     */
+    static void Release() {
+        State &state = ArenaAllocator::Current();
+        ArenaAllocator::FreeChunks(state.head_);
+        state.head_ = nullptr;
+        state.pos_ = state.end_ = nullptr;
+    }
+
+    /**
+     * @return the amount of bytes handed out since the last Reset(), in the current chunk.
+     */
+    static SizeType Used() noexcept {
+        State &state = ArenaAllocator::Current();
+        return state.head_ ? state.pos_ - (reinterpret_cast<unsigned char *>(state.head_) + kHeader) : 0;
+    }
+
+private:
+    struct Chunk {
+        Chunk *next_;
+        SizeType size_;
+    };
+
+    struct State {
+        Chunk *head_ = nullptr; // the current chunk; older chunks are linked behind it.
+        unsigned char *pos_ = nullptr; // the next free byte.
+        unsigned char *end_ = nullptr; // the end of the current chunk.
+
+        ~State() {
+            ArenaAllocator::FreeChunks(head_);
+        }
+    };
+
+    static constexpr SizeType kHeader = Internal::AlignUp(sizeof(Chunk));
+    static constexpr SizeType kMinChunk = 64 * 1024;
+
+    static State &Current() {
+        static thread_local State state;
+        return state;
+    }
+
+    static void Grow(State &state, SizeType size) {
+        SizeType chunk_size = state.head_ ? state.head_->size_ * 2 : kMinChunk;
+        if (chunk_size < size + kHeader) {
+            chunk_size = size + kHeader;
+        }
+        Chunk *chunk = static_cast<Chunk *>(::malloc(chunk_size));
+        assert(chunk);
+        chunk->next_ = state.head_;
+        chunk->size_ = chunk_size;
+        state.head_ = chunk;
+        state.pos_ = reinterpret_cast<unsigned char *>(chunk) + kHeader;
+        state.end_ = reinterpret_cast<unsigned char *>(chunk) + chunk_size;
+    }
+
+    static void FreeChunks(Chunk *chunk) {
+        while (chunk) {
+            Chunk *next = chunk->next_;
+            ::free(chunk);
+            chunk = next;
+        }
+    }
+};
+
+/**
+ * Size-class pool.
+ * Requests are rounded up to a power of two between \c kMinClass and \c kMaxClass
+ * bytes. Each class keeps a free list, so a freed block is handed out again to
+ * the next request of the same class. Larger requests go to the C heap.
+ *
+ * Reset() drops every free list and returns all chunks to the C heap, which
+ * invalidates every pooled block allocated on the current thread at once.
+ * @tparam Tag distinguishes independent pools.
+ */
+template<typename Tag = void>
+class PoolAllocator {
+public:
+    static void *Allocate(SizeType size) {
+        if (size > kMaxClass) {
+            return ::malloc(size);
+        }
+        State &state = PoolAllocator::Current();
+        SizeType index = PoolAllocator::ClassIndex(size);
+        if (Node *node = state.free_[index]) {
+            state.free_[index] = node->next_;
+            return node;
+        }
+        SizeType block = kMinClass << index;
+        if (SizeType(state.end_ - state.pos_) < block) {
+            PoolAllocator::Grow(state);
+        }
+        void *rtn = state.pos_;
+        state.pos_ += block;
+        return rtn;
+    }
+
+    static void *Reallocate(void *ptr, SizeType old_size, SizeType new_size) {
+        if (!ptr) {
+            return PoolAllocator::Allocate(new_size);
+        }
+        if (old_size > kMaxClass && new_size > kMaxClass) {
+            return ::realloc(ptr, new_size);
+        }
+        if (old_size <= kMaxClass && new_size <= kMaxClass &&
+            PoolAllocator::ClassIndex(old_size) == PoolAllocator::ClassIndex(new_size)) {
+            return ptr; // still fits in the same class.
+        }
+        void *rtn = PoolAllocator::Allocate(new_size);
+        ::memcpy(rtn, ptr, old_size < new_size ? old_size : new_size);
+        PoolAllocator::Free(ptr, old_size);
+        return rtn;
+    }
+
+    static void Free(void *ptr, SizeType size) {
+        if (!ptr) {
+            return;
+        }
+        if (size > kMaxClass) {
+            ::free(ptr);
+            return;
+        }
+        State &state = PoolAllocator::Current();
+        SizeType index = PoolAllocator::ClassIndex(size);
+        Node *node = static_cast<Node *>(ptr);
+        node->next_ = state.free_[index];
+        state.free_[index] = node;
+    }
+
+    /**
+     * Invalidates every pooled block allocated on the current thread.
+     * Blocks larger than \c kMaxClass come from the C heap and are not affected.
+     */
+    static void Reset() {
+        State &state = PoolAllocator::Current();
+        state.Release();
+    }
+
+    static constexpr SizeType kMinClass = 16;
+    static constexpr SizeType kMaxClass = 16 * 1024;
+
+private:
+    struct Node {
+        Node *next_;
+    };
+
+    struct Chunk {
+        Chunk *next_;
+    };
+
+    static constexpr SizeType kClassCount = 11; // 16, 32, ..., 16 KiB
+    static constexpr SizeType kHeader = Internal::AlignUp(sizeof(Chunk));
+    static constexpr SizeType kChunk = 256 * 1024;
+
+    struct State {
+        Node *free_[kClassCount] = {};
+        Chunk *chunks_ = nullptr;
+        unsigned char *pos_ = nullptr;
+        unsigned char *end_ = nullptr;
+
+        void Release() {
+            for (Chunk *chunk = chunks_; chunk;) {
+                Chunk *next = chunk->next_;
+                ::free(chunk);
+                chunk = next;
+            }
+            ::memset(free_, 0, sizeof(free_));
+            chunks_ = nullptr;
+            pos_ = end_ = nullptr;
+        }
+
+        ~State() {
+            Release();
+        }
+    };
+
+    static State &Current() {
+        static thread_local State state;
+        return state;
+    }
+
+    static SizeType ClassIndex(SizeType size) {
+        SizeType index = 0;
+        for (SizeType block = kMinClass; block < size; block <<= 1, ++index);
+        return index;
+    }
+
+    static void Grow(State &state) {
+        // The tail of the old chunk is lost, at most kMaxClass bytes per chunk.
+        Chunk *chunk = static_cast<Chunk *>(::malloc(kChunk));
+        assert(chunk);
+        chunk->next_ = state.chunks_;
+        state.chunks_ = chunk;
+        state.pos_ = reinterpret_cast<unsigned char *>(chunk) + kHeader;
+        state.end_ = reinterpret_cast<unsigned char *>(chunk) + kChunk;
+    }
+};
+
+#endif //ESCAPIST_ALLOCATOR_H
@@ -55,7 +55,19 @@
 #error "Unsupported Platform"
 #endif
 
+/**
+ * Architecture Detection:
+ * SIMD kernels are only available on x86, where SSE2 is the baseline of 64-bit mode.
+ * Wider instruction sets are selected at runtime, see internal/simd.h.
+ */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ESCAPIST_ARCH_X86
+#endif
+
 #include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
 
 // Type Unification:
 //  - Char : the type storing a character.
@@ -84,40 +96,81 @@ template<typename T>
 class Collection {
 };
 
-template<typename T>
+/**
+ * The iterator protocol, resolved at compile time by CRTP instead of virtual calls.
+ * An iterator derives from IIterator<Derived, Element>, where \c Element is const for
+ * read-only iterators, and provides:
+ *  - Instance(): the element it refers to.
+ *  - Next(), Prev(): the iterator to the following and to the preceding element.
+ *  - Equals(other): true if both refer to the same element.
+ * IIterator adds the standard operators on top of them, thus every iterator works with
+ * range-for and the std algorithms as a bidirectional iterator, and a loop over it inlines
+ * to a loop over its position.
+ */
+template<typename Derived, typename Element>
 class IIterator {
 public:
-    IIterator() = delete;
-
-    explicit IIterator(T *const &pos) : pos_(pos) {}
-
-    IIterator(const IIterator<T> &it) : pos_(it.pos_) {}
-
-    virtual ~IIterator() = default;
-
-    virtual T &Instance() = 0;
-
-    virtual IIterator<T> &Next() const noexcept = 0;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename std::remove_const<Element>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Element *;
+    using reference = Element &;
+
+    reference operator*() const {
+        return Self().Instance();
+    }
+
+    pointer operator->() const {
+        return &Self().Instance();
+    }
+
+    Derived &operator++() {
+        return Self() = Self().Next();
+    }
+
+    Derived operator++(int) {
+        Derived rtn(Self());
+        Self() = Self().Next();
+        return rtn;
+    }
+
+    Derived &operator--() {
+        return Self() = Self().Prev();
+    }
+
+    Derived operator--(int) {
+        Derived rtn(Self());
+        Self() = Self().Prev();
+        return rtn;
+    }
+
+    friend bool operator==(const Derived &left, const Derived &right) {
+        return left.Equals(right);
+    }
+
+    friend bool operator!=(const Derived &left, const Derived &right) {
+        return !left.Equals(right);
+    }
 
 protected:
-    T *pos_;
-};
-
-template<typename T>
-class IConstIterator {
-public:
-    IConstIterator() = delete;
-
-    explicit IConstIterator(T *const &pos) : pos_(pos) {}
-
-    IConstIterator(const IConstIterator<T> &it) : pos_(it.pos_) {}
+    IIterator() = default;
 
-    virtual ~IConstIterator() = default;
-
-    virtual T &Instance() = 0;
+    ~IIterator() = default;
 
 private:
-    T *const &pos_;
+    Derived &Self() noexcept {
+        return static_cast<Derived &>(*this);
+    }
+
+    const Derived &Self() const noexcept {
+        return static_cast<const Derived &>(*this);
+    }
 };
 
+/**
+ * The protocol of read-only iterators.
+ */
+template<typename Derived, typename T>
+using IConstIterator = IIterator<Derived, const T>;
+
 #endif //ESCAPIST_BASE_H
\ No newline at end of file
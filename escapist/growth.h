@@ -0,0 +1,56 @@
+/**
+ * Growth policies for the containers in this library.
+ *
+ * When a container runs out of room it asks its policy how many slots the new
+ * block should have. A policy is a struct with a single static function, so it
+ * costs nothing to carry around:
+ *  - Cap(size, min_cap): returns a capacity no smaller than \p size, or 0 if
+ *    \p size is 0. \p min_cap is the container's preferred floor for small
+ *    blocks, which a policy may ignore.
+ *
+ * Four policies are provided:
+ *  - HalfGrowth: 1.5x, the default. A good balance between copies and slack.
+ *  - DoubleGrowth: 2x, fewer reallocations at the price of up to 50% slack.
+ *  - PowerOfTwoGrowth: rounds up to a power of two, which suits allocators with
+ *    power-of-two size classes, such as PoolAllocator.
+ *  - ExactGrowth: no slack at all, every growth reallocates. Meant for lists
+ *    that are built once and kept for long, where footprint matters most.
+ */
+
+#ifndef ESCAPIST_GROWTH_H
+#define ESCAPIST_GROWTH_H
+
+#include "base.h"
+
+struct HalfGrowth {
+    static constexpr SizeType Cap(SizeType size, SizeType min_cap) {
+        return !size ? 0 : (min_cap && min_cap * 0.75 >= size) ? min_cap : SizeType(size * 1.5);
+    }
+};
+
+struct DoubleGrowth {
+    static constexpr SizeType Cap(SizeType size, SizeType min_cap) {
+        return !size ? 0 : (min_cap / 2 >= size) ? min_cap : size * 2;
+    }
+};
+
+struct PowerOfTwoGrowth {
+    static constexpr SizeType Cap(SizeType size, SizeType min_cap) {
+        SizeType rtn = size > min_cap ? size : min_cap;
+        if (!size || !(rtn & (rtn - 1))) {
+            return size ? rtn : 0;
+        }
+        for (SizeType shift = 1; shift < sizeof(SizeType) * 8; shift <<= 1) {
+            rtn |= rtn >> shift;
+        }
+        return rtn + 1;
+    }
+};
+
+struct ExactGrowth {
+    static constexpr SizeType Cap(SizeType size, SizeType /*min_cap*/) {
+        return size;
+    }
+};
+
+#endif //ESCAPIST_GROWTH_H
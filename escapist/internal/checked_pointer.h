@@ -0,0 +1,153 @@
+#ifndef ESCAPIST_CHECKED_POINTER_H
+#define ESCAPIST_CHECKED_POINTER_H
+
+#include "../base.h"
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+/**
+ * Range iterators of contiguous containers.
+ * Release builds iterate with plain pointers, so that a range-for compiles to a pointer loop.
+ * Debug builds use CheckedPointer instead, which asserts that every step and every access
+ * stays inside the range the iterator was created for.
+ */
+namespace Internal {
+    /**
+     * A random access iterator holding a pointer and the bounds [first, last) it may walk.
+     * It cannot tell whether its container has reallocated since, only whether it left its range.
+     */
+    template<typename T>
+    class CheckedPointer {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename std::remove_const<T>::type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using reference = T &;
+
+        CheckedPointer() noexcept: pos_(nullptr), first_(nullptr), last_(nullptr) {}
+
+        CheckedPointer(T *pos, T *first, T *last) noexcept: pos_(pos), first_(first), last_(last) {}
+
+        operator CheckedPointer<const T>() const noexcept {
+            return CheckedPointer<const T>(pos_, first_, last_);
+        }
+
+        T &operator*() const noexcept {
+            assert(first_ <= pos_ && pos_ < last_);
+            return *pos_;
+        }
+
+        T *operator->() const noexcept {
+            assert(first_ <= pos_ && pos_ < last_);
+            return pos_;
+        }
+
+        T &operator[](difference_type offset) const noexcept {
+            return *(*this + offset);
+        }
+
+        CheckedPointer &operator++() noexcept {
+            assert(pos_ < last_);
+            ++pos_;
+            return *this;
+        }
+
+        CheckedPointer operator++(int) noexcept {
+            CheckedPointer rtn(*this);
+            ++*this;
+            return rtn;
+        }
+
+        CheckedPointer &operator--() noexcept {
+            assert(first_ < pos_);
+            --pos_;
+            return *this;
+        }
+
+        CheckedPointer operator--(int) noexcept {
+            CheckedPointer rtn(*this);
+            --*this;
+            return rtn;
+        }
+
+        CheckedPointer &operator+=(difference_type offset) noexcept {
+            assert(offset >= first_ - pos_ && offset <= last_ - pos_);
+            pos_ += offset;
+            return *this;
+        }
+
+        CheckedPointer &operator-=(difference_type offset) noexcept {
+            return *this += -offset;
+        }
+
+        CheckedPointer operator+(difference_type offset) const noexcept {
+            CheckedPointer rtn(*this);
+            return rtn += offset;
+        }
+
+        friend CheckedPointer operator+(difference_type offset, const CheckedPointer &it) noexcept {
+            return it + offset;
+        }
+
+        CheckedPointer operator-(difference_type offset) const noexcept {
+            CheckedPointer rtn(*this);
+            return rtn -= offset;
+        }
+
+        difference_type operator-(const CheckedPointer &other) const noexcept {
+            assert(first_ == other.first_);
+            return pos_ - other.pos_;
+        }
+
+        bool operator==(const CheckedPointer &other) const noexcept {
+            return pos_ == other.pos_;
+        }
+
+        bool operator!=(const CheckedPointer &other) const noexcept {
+            return pos_ != other.pos_;
+        }
+
+        bool operator<(const CheckedPointer &other) const noexcept {
+            return pos_ < other.pos_;
+        }
+
+        bool operator>(const CheckedPointer &other) const noexcept {
+            return pos_ > other.pos_;
+        }
+
+        bool operator<=(const CheckedPointer &other) const noexcept {
+            return pos_ <= other.pos_;
+        }
+
+        bool operator>=(const CheckedPointer &other) const noexcept {
+            return pos_ >= other.pos_;
+        }
+
+    private:
+        T *pos_;
+        T *first_;
+        T *last_;
+    };
+
+#ifdef NDEBUG
+    template<typename T>
+    using RangeIterator = T *;
+
+    template<typename T>
+    inline T *MakeRangeIterator(T *pos, T * /*first*/, T * /*last*/) noexcept {
+        return pos;
+    }
+#else
+    template<typename T>
+    using RangeIterator = CheckedPointer<T>;
+
+    template<typename T>
+    inline CheckedPointer<T> MakeRangeIterator(T *pos, T *first, T *last) noexcept {
+        return CheckedPointer<T>(pos, first, last);
+    }
+#endif
+}
+
+#endif //ESCAPIST_CHECKED_POINTER_H
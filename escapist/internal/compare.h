@@ -0,0 +1,165 @@
+#ifndef ESCAPIST_COMPARE_H
+#define ESCAPIST_COMPARE_H
+
+#include "../base.h"
+#include "type_trait.h"
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Default comparators and element-wise comparison of contiguous ranges.
+ * Comparators are functors taken by template, so that calls can be inlined.
+ */
+namespace Internal {
+    /**
+     * The default ordering, by <tt>operator<</tt>.
+     */
+    template<typename T>
+    struct LessThan {
+        bool operator()(const T &left, const T &right) const {
+            return left < right;
+        }
+    };
+
+    /**
+     * The default equality, by the \c TypeTrait of \c T.
+     */
+    template<typename T>
+    struct EqualTo {
+        bool operator()(const T &left, const T &right) const {
+            return TypeTraitPatternSelector<T>::Type::Equals(left, right);
+        }
+    };
+
+    /**
+     * The default three-way comparison, by <tt>operator<</tt>.
+     * @return negative, zero or positive
+     */
+    template<typename T>
+    struct ThreeWayCompare {
+        int operator()(const T &left, const T &right) const {
+            return left < right ? -1 : (right < left ? 1 : 0);
+        }
+    };
+
+    enum class RangeComparePattern : short {
+        // Every element goes through the comparator.
+        Generic,
+        // Equal elements have equal bytes, thus whole blocks are compared by memcmp.
+        Bitwise,
+        // Floating points: +0 equals -0 and NaN equals nothing, so blocks are compared
+        // by a branch-free loop the compiler can vectorize.
+        Floating
+    };
+
+    template<typename T, typename Comparator, typename Default>
+    struct RangeComparePatternDefiner {
+        static constexpr bool kDefault = std::is_same<Comparator, Default>::value &&
+                                         TypeTraitPatternDefiner<T>::Pattern == TypeTraitPattern::Pod;
+        static constexpr RangeComparePattern Pattern =
+                !kDefault ? RangeComparePattern::Generic :
+                (std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value)
+                ? RangeComparePattern::Bitwise :
+                std::is_floating_point<T>::value ? RangeComparePattern::Floating : RangeComparePattern::Generic;
+    };
+
+    // The amount of elements checked at once before looking for the exact mismatch.
+    constexpr SizeType kRangeCompareBlock = 32;
+
+    template<typename T>
+    inline bool BlockEquals(const T *left, const T *right, SizeType count,
+                            std::integral_constant<RangeComparePattern, RangeComparePattern::Bitwise>) {
+        return !::memcmp(left, right, count * sizeof(T));
+    }
+
+    template<typename T>
+    inline bool BlockEquals(const T *left, const T *right, SizeType count,
+                            std::integral_constant<RangeComparePattern, RangeComparePattern::Floating>) {
+        bool diff = false;
+        for (SizeType i = 0; i < count; ++i) {
+            diff |= !(left[i] == right[i]);
+        }
+        return !diff;
+    }
+
+    template<typename T, RangeComparePattern Pattern>
+    struct RangeCompare {
+        template<typename Equal>
+        static bool Equals(const T *left, const T *right, SizeType count, Equal &equal) {
+            std::integral_constant<RangeComparePattern, Pattern> pattern;
+            for (; count >= kRangeCompareBlock; left += kRangeCompareBlock, right += kRangeCompareBlock,
+                    count -= kRangeCompareBlock) {
+                if (!BlockEquals(left, right, kRangeCompareBlock, pattern)) {
+                    return false;
+                }
+            }
+            return !count || BlockEquals(left, right, count, pattern);
+        }
+
+        template<typename Compare>
+        static int CompareTo(const T *left, const T *right, SizeType count, Compare &compare) {
+            std::integral_constant<RangeComparePattern, Pattern> pattern;
+            for (; count; ) {
+                SizeType block = count < kRangeCompareBlock ? count : kRangeCompareBlock;
+                if (!BlockEquals(left, right, block, pattern)) {
+                    // The mismatch is in this block, unless it is a NaN that compares as neither.
+                    for (SizeType i = 0; i < block; ++i) {
+                        if (int rtn = compare(left[i], right[i])) {
+                            return rtn;
+                        }
+                    }
+                }
+                left += block, right += block, count -= block;
+            }
+            return 0;
+        }
+    };
+
+    template<typename T>
+    struct RangeCompare<T, RangeComparePattern::Generic> {
+        template<typename Equal>
+        static bool Equals(const T *left, const T *right, SizeType count, Equal &equal) {
+            for (; count > 0; ++left, ++right, --count) {
+                if (!equal(*left, *right)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename Compare>
+        static int CompareTo(const T *left, const T *right, SizeType count, Compare &compare) {
+            for (; count > 0; ++left, ++right, --count) {
+                if (int rtn = compare(*left, *right)) {
+                    return rtn;
+                }
+            }
+            return 0;
+        }
+    };
+
+    /**
+     * @return true if \p count elements starting from \p left and \p right are pairwise equal
+     */
+    template<typename T, typename Equal>
+    inline bool RangeEquals(const T *left, const T *right, SizeType count, Equal &equal) {
+        return RangeCompare<T, RangeComparePatternDefiner<T, Equal, EqualTo<T>>::Pattern>::Equals(
+                left, right, count, equal);
+    }
+
+    /**
+     * Compares two ranges lexicographically, the shorter one goes first if it is a prefix of the other.
+     * @return negative, zero or positive
+     */
+    template<typename T, typename Compare>
+    inline int RangeCompareTo(const T *left, SizeType left_count, const T *right, SizeType right_count,
+                              Compare &compare) {
+        if (int rtn = RangeCompare<T, RangeComparePatternDefiner<T, Compare, ThreeWayCompare<T>>::Pattern>::CompareTo(
+                left, right, left_count < right_count ? left_count : right_count, compare)) {
+            return rtn;
+        }
+        return left_count < right_count ? -1 : (left_count > right_count ? 1 : 0);
+    }
+}
+
+#endif //ESCAPIST_COMPARE_H
@@ -0,0 +1,138 @@
+#ifndef ESCAPIST_HASH_H
+#define ESCAPIST_HASH_H
+
+#include "../base.h"
+#include "compare.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+/**
+ * Non-cryptographic hashing of contiguous ranges, after wyhash (final version 4).
+ * Bytes are read in native order, thus hashes are only meant for the running process:
+ * they differ across endianness and must not be stored.
+ */
+namespace Internal {
+    constexpr std::uint64_t kHashSecret[4] = {0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+                                              0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+    /**
+     * Multiplies \p a and \p b into 128 bits, and stores the low half in \p a and the high half in \p b.
+     */
+    inline void HashMultiply(std::uint64_t &a, std::uint64_t &b) noexcept {
+#if defined(__SIZEOF_INT128__)
+        unsigned __int128 r = a;
+        r *= b;
+        a = std::uint64_t(r), b = std::uint64_t(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        a = _umul128(a, b, &b);
+#else
+        std::uint64_t ha = a >> 32, hb = b >> 32, la = std::uint32_t(a), lb = std::uint32_t(b);
+        std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+        std::uint64_t lo = t + (rm1 << 32);
+        c += lo < t;
+        a = lo, b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+    }
+
+    inline std::uint64_t HashMix(std::uint64_t a, std::uint64_t b) noexcept {
+        HashMultiply(a, b);
+        return a ^ b;
+    }
+
+    inline std::uint64_t HashRead8(const unsigned char *p) noexcept {
+        std::uint64_t rtn;
+        ::memcpy(&rtn, p, 8);
+        return rtn;
+    }
+
+    inline std::uint64_t HashRead4(const unsigned char *p) noexcept {
+        std::uint32_t rtn;
+        ::memcpy(&rtn, p, 4);
+        return rtn;
+    }
+
+    /**
+     * @return the hash of \p len bytes starting from \p data
+     */
+    inline std::uint64_t HashBytes(const void *data, SizeType len, std::uint64_t seed = 0) noexcept {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        std::uint64_t a, b;
+        seed ^= HashMix(seed ^ kHashSecret[0], kHashSecret[1]);
+        if (len <= 16) {
+            if (len >= 4) {
+                SizeType step = (len >> 3) << 2;
+                a = (HashRead4(p) << 32) | HashRead4(p + step);
+                b = (HashRead4(p + len - 4) << 32) | HashRead4(p + len - 4 - step);
+            } else if (len > 0) {
+                a = (std::uint64_t(p[0]) << 16) | (std::uint64_t(p[len >> 1]) << 8) | p[len - 1];
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+        } else {
+            SizeType i = len;
+            if (i > 48) {
+                std::uint64_t see1 = seed, see2 = seed;
+                do {
+                    seed = HashMix(HashRead8(p) ^ kHashSecret[1], HashRead8(p + 8) ^ seed);
+                    see1 = HashMix(HashRead8(p + 16) ^ kHashSecret[2], HashRead8(p + 24) ^ see1);
+                    see2 = HashMix(HashRead8(p + 32) ^ kHashSecret[3], HashRead8(p + 40) ^ see2);
+                    p += 48, i -= 48;
+                } while (i > 48);
+                seed ^= see1 ^ see2;
+            }
+            for (; i > 16; p += 16, i -= 16) {
+                seed = HashMix(HashRead8(p) ^ kHashSecret[1], HashRead8(p + 8) ^ seed);
+            }
+            a = HashRead8(p + i - 16);
+            b = HashRead8(p + i - 8);
+        }
+        a ^= kHashSecret[1];
+        b ^= seed;
+        HashMultiply(a, b);
+        return HashMix(a ^ kHashSecret[0] ^ std::uint64_t(len), b ^ kHashSecret[1]);
+    }
+
+    /**
+     * The default hash of a single element: its Hash() member if it has one, std::hash otherwise.
+     */
+    template<typename T, typename = void>
+    struct HashOf {
+        std::uint64_t operator()(const T &value) const {
+            return std::hash<T>()(value);
+        }
+    };
+
+    template<typename T>
+    struct HashOf<T, decltype(void(std::declval<const T &>().Hash()))> {
+        std::uint64_t operator()(const T &value) const {
+            return value.Hash();
+        }
+    };
+
+    /**
+     * @return the hash of \p count elements starting from \p first, equal ranges have equal hashes.
+     * Elements whose equality is bitwise are hashed as bytes, the others one by one.
+     */
+    template<typename T>
+    inline std::uint64_t RangeHash(const T *first, SizeType count) {
+        if (RangeComparePatternDefiner<T, EqualTo<T>, EqualTo<T>>::Pattern == RangeComparePattern::Bitwise) {
+            return HashBytes(first, count * sizeof(T));
+        }
+        HashOf<T> hash;
+        std::uint64_t rtn = kHashSecret[0] ^ std::uint64_t(count);
+        for (const T *last = first + count; first != last; ++first) {
+            rtn = HashMix(rtn ^ hash(*first), kHashSecret[1]);
+        }
+        return rtn;
+    }
+}
+
+#endif //ESCAPIST_HASH_H
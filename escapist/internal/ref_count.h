@@ -32,9 +32,55 @@ namespace Internal {
             return *this;
         }
 
+        /**
+         * Decrements the count in a single step.
+         * @return true if the caller held the last reference, thus the block can be freed.
+         */
+        bool ReleaseRef() {
+            return atom.fetch_sub(1, std::memory_order::memory_order_acq_rel) == 1;
+        }
+
     private:
         std::atomic<int> atom;
     };
+
+    /**
+     * The same interface as ReferenceCount, for instances that never cross threads.
+     */
+    class PlainReferenceCount final {
+    public:
+        PlainReferenceCount() = delete;
+
+        explicit PlainReferenceCount(const int &value) noexcept: value_(value) {}
+
+        PlainReferenceCount(const PlainReferenceCount &other) = delete;
+
+        int Value() const {
+            return value_;
+        }
+
+        PlainReferenceCount &SetValue(const int &value) {
+            value_ = value;
+            return *this;
+        }
+
+        PlainReferenceCount &IncrementRef() {
+            ++value_;
+            return *this;
+        }
+
+        PlainReferenceCount &DecrementRef() {
+            --value_;
+            return *this;
+        }
+
+        bool ReleaseRef() {
+            return --value_ == 0;
+        }
+
+    private:
+        int value_;
+    };
 }
 
 #endif //ESCAPIST_REF_COUNT_H
@@ -0,0 +1,1177 @@
+/**
+ * SIMD kernels shared by the containers.
+ * SSE2 is used whenever the compiler targets it, which is always the case in 64-bit mode.
+ * AVX2 kernels are compiled with a function-level target attribute and selected at runtime,
+ * thus the library does not need to be built with -mavx2 and still runs on older CPUs.
+ * Every kernel has a scalar fallback, which is the only path on other architectures.
+ */
+
+#ifndef ESCAPIST_SIMD_H
+#define ESCAPIST_SIMD_H
+
+#include "../base.h"
+#include "type_trait.h"
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(ESCAPIST_ARCH_X86) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ESCAPIST_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define ESCAPIST_SIMD_AVX2
+#define ESCAPIST_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Scans of null-terminated strings may read past the terminator, within the same page.
+// That cannot fault, but the address sanitizer cannot tell, thus such kernels opt out of it.
+#if defined(__GNUC__) || defined(__clang__)
+#define ESCAPIST_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define ESCAPIST_NO_SANITIZE_ADDRESS
+#endif
+
+namespace Internal {
+    /**
+     * @param mask nonzero
+     * @return the index of the lowest set bit
+     */
+    inline unsigned CountTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return unsigned(index);
+#else
+        return unsigned(__builtin_ctz(mask));
+#endif
+    }
+
+    /**
+     * @param mask nonzero
+     * @return the index of the highest set bit
+     */
+    inline unsigned HighestBit(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanReverse(&index, mask);
+        return unsigned(index);
+#else
+        return unsigned(31 - __builtin_clz(mask));
+#endif
+    }
+
+    inline unsigned PopCount(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned rtn = 0;
+        for (; mask; mask &= mask - 1, ++rtn);
+        return rtn;
+#else
+        return unsigned(__builtin_popcount(mask));
+#endif
+    }
+
+    /**
+     * @return true if the running CPU supports AVX2, checked once.
+     */
+    inline bool CpuSupportsAvx2() {
+#ifdef ESCAPIST_SIMD_AVX2
+        static const bool rtn = __builtin_cpu_supports("avx2");
+        return rtn;
+#else
+        return false;
+#endif
+    }
+
+    template<typename T>
+    inline const T *FindScalar(const T *first, const T *last, const T &value) {
+        for (; first != last; ++first) {
+            if (*first == value) {
+                return first;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    inline const T *ReverseFindScalar(const T *first, const T *last, const T &value) {
+        while (last != first) {
+            if (*--last == value) {
+                return last;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    inline SizeType CountScalar(const T *first, const T *last, const T &value) {
+        SizeType rtn = 0;
+        for (; first != last; ++first) {
+            rtn += (*first == value);
+        }
+        return rtn;
+    }
+
+#ifdef ESCAPIST_SIMD_SSE2
+    /**
+     * SSE2 operations on 16 bytes holding elements of \p Size bytes.
+     * EqualMask returns the byte mask of _mm_movemask_epi8, thus every matching element sets \p Size bits.
+     * Greater, for integers of up to 4 bytes, compares signed lanes and returns all bits set where \p left is greater.
+     */
+    template<SizeType Size, bool Floating>
+    struct Sse2Ops;
+
+    struct Sse2IntegerOps {
+        using Vector = __m128i;
+
+        ESCAPIST_NO_SANITIZE_ADDRESS static inline Vector Load(const void *pos) {
+            return _mm_loadu_si128(static_cast<const __m128i *>(pos));
+        }
+
+        ESCAPIST_NO_SANITIZE_ADDRESS static inline Vector LoadAligned(const void *pos) {
+            return _mm_load_si128(static_cast<const __m128i *>(pos));
+        }
+
+        static inline void Store(void *pos, Vector value) {
+            _mm_storeu_si128(static_cast<__m128i *>(pos), value);
+        }
+    };
+
+    template<>
+    struct Sse2Ops<1, false> : Sse2IntegerOps {
+        static inline Vector Set1(const void *value) {
+            char v;
+            ::memcpy(&v, value, 1);
+            return _mm_set1_epi8(v);
+        }
+
+        static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(left, right)));
+        }
+
+        static inline Vector Greater(Vector left, Vector right) {
+            return _mm_cmpgt_epi8(left, right);
+        }
+    };
+
+    template<>
+    struct Sse2Ops<2, false> : Sse2IntegerOps {
+        static inline Vector Set1(const void *value) {
+            short v;
+            ::memcpy(&v, value, 2);
+            return _mm_set1_epi16(v);
+        }
+
+        static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi16(left, right)));
+        }
+
+        static inline Vector Greater(Vector left, Vector right) {
+            return _mm_cmpgt_epi16(left, right);
+        }
+    };
+
+    template<>
+    struct Sse2Ops<4, false> : Sse2IntegerOps {
+        static inline Vector Set1(const void *value) {
+            int v;
+            ::memcpy(&v, value, 4);
+            return _mm_set1_epi32(v);
+        }
+
+        static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi32(left, right)));
+        }
+
+        static inline Vector Greater(Vector left, Vector right) {
+            return _mm_cmpgt_epi32(left, right);
+        }
+    };
+
+    template<>
+    struct Sse2Ops<8, false> : Sse2IntegerOps {
+        static inline Vector Set1(const void *value) {
+            long long v;
+            ::memcpy(&v, value, 8);
+            return _mm_set1_epi64x(v);
+        }
+
+        static inline unsigned EqualMask(Vector left, Vector right) {
+            // SSE2 has no 64-bit compare: both 32-bit halves must match.
+            Vector half = _mm_cmpeq_epi32(left, right);
+            return unsigned(_mm_movemask_epi8(_mm_and_si128(half, _mm_shuffle_epi32(half, 0xB1))));
+        }
+    };
+
+    template<>
+    struct Sse2Ops<4, true> {
+        using Vector = __m128;
+
+        static inline Vector Load(const void *pos) {
+            return _mm_loadu_ps(static_cast<const float *>(pos));
+        }
+
+        static inline Vector Set1(const void *value) {
+            return _mm_set1_ps(*static_cast<const float *>(value));
+        }
+
+        static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm_movemask_epi8(_mm_castps_si128(_mm_cmpeq_ps(left, right))));
+        }
+    };
+
+    template<>
+    struct Sse2Ops<8, true> {
+        using Vector = __m128d;
+
+        static inline Vector Load(const void *pos) {
+            return _mm_loadu_pd(static_cast<const double *>(pos));
+        }
+
+        static inline Vector Set1(const void *value) {
+            return _mm_set1_pd(*static_cast<const double *>(value));
+        }
+
+        static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm_movemask_epi8(_mm_castpd_si128(_mm_cmpeq_pd(left, right))));
+        }
+    };
+
+    template<typename T>
+    const T *FindSse2(const T *first, const T *last, const T &value) {
+        using Ops = Sse2Ops<sizeof(T), std::is_floating_point<T>::value>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        auto needle = Ops::Set1(&value);
+        for (; SizeType(last - first) >= kLanes; first += kLanes) {
+            if (unsigned mask = Ops::EqualMask(Ops::Load(first), needle)) {
+                return first + CountTrailingZeros(mask) / sizeof(T);
+            }
+        }
+        return FindScalar(first, last, value);
+    }
+
+    template<typename T>
+    const T *ReverseFindSse2(const T *first, const T *last, const T &value) {
+        using Ops = Sse2Ops<sizeof(T), std::is_floating_point<T>::value>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        auto needle = Ops::Set1(&value);
+        for (; SizeType(last - first) >= kLanes;) {
+            last -= kLanes;
+            if (unsigned mask = Ops::EqualMask(Ops::Load(last), needle)) {
+                return last + HighestBit(mask) / sizeof(T);
+            }
+        }
+        return ReverseFindScalar(first, last, value);
+    }
+
+    template<typename T>
+    SizeType CountSse2(const T *first, const T *last, const T &value) {
+        using Ops = Sse2Ops<sizeof(T), std::is_floating_point<T>::value>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        auto needle = Ops::Set1(&value);
+        SizeType bits = 0;
+        for (; SizeType(last - first) >= kLanes; first += kLanes) {
+            bits += PopCount(Ops::EqualMask(Ops::Load(first), needle));
+        }
+        return bits / sizeof(T) + CountScalar(first, last, value);
+    }
+#endif
+
+#ifdef ESCAPIST_SIMD_AVX2
+    /**
+     * AVX2 operations on 32 bytes, the counterpart of Sse2Ops.
+     */
+    template<SizeType Size, bool Floating>
+    struct Avx2Ops;
+
+    struct Avx2IntegerOps {
+        using Vector = __m256i;
+
+        ESCAPIST_TARGET_AVX2 ESCAPIST_NO_SANITIZE_ADDRESS static inline Vector Load(const void *pos) {
+            return _mm256_loadu_si256(static_cast<const __m256i *>(pos));
+        }
+
+        ESCAPIST_TARGET_AVX2 ESCAPIST_NO_SANITIZE_ADDRESS static inline Vector LoadAligned(const void *pos) {
+            return _mm256_load_si256(static_cast<const __m256i *>(pos));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline void Store(void *pos, Vector value) {
+            _mm256_storeu_si256(static_cast<__m256i *>(pos), value);
+        }
+    };
+
+    template<>
+    struct Avx2Ops<1, false> : Avx2IntegerOps {
+        ESCAPIST_TARGET_AVX2 static inline Vector Set1(const void *value) {
+            char v;
+            ::memcpy(&v, value, 1);
+            return _mm256_set1_epi8(v);
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(left, right)));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline Vector Greater(Vector left, Vector right) {
+            return _mm256_cmpgt_epi8(left, right);
+        }
+    };
+
+    template<>
+    struct Avx2Ops<2, false> : Avx2IntegerOps {
+        ESCAPIST_TARGET_AVX2 static inline Vector Set1(const void *value) {
+            short v;
+            ::memcpy(&v, value, 2);
+            return _mm256_set1_epi16(v);
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi16(left, right)));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline Vector Greater(Vector left, Vector right) {
+            return _mm256_cmpgt_epi16(left, right);
+        }
+    };
+
+    template<>
+    struct Avx2Ops<4, false> : Avx2IntegerOps {
+        ESCAPIST_TARGET_AVX2 static inline Vector Set1(const void *value) {
+            int v;
+            ::memcpy(&v, value, 4);
+            return _mm256_set1_epi32(v);
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi32(left, right)));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline Vector Greater(Vector left, Vector right) {
+            return _mm256_cmpgt_epi32(left, right);
+        }
+    };
+
+    template<>
+    struct Avx2Ops<8, false> : Avx2IntegerOps {
+        ESCAPIST_TARGET_AVX2 static inline Vector Set1(const void *value) {
+            long long v;
+            ::memcpy(&v, value, 8);
+            return _mm256_set1_epi64x(v);
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi64(left, right)));
+        }
+    };
+
+    template<>
+    struct Avx2Ops<4, true> {
+        using Vector = __m256;
+
+        ESCAPIST_TARGET_AVX2 static inline Vector Load(const void *pos) {
+            return _mm256_loadu_ps(static_cast<const float *>(pos));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline Vector Set1(const void *value) {
+            return _mm256_set1_ps(*static_cast<const float *>(value));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm256_movemask_epi8(_mm256_castps_si256(_mm256_cmp_ps(left, right, _CMP_EQ_OQ))));
+        }
+    };
+
+    template<>
+    struct Avx2Ops<8, true> {
+        using Vector = __m256d;
+
+        ESCAPIST_TARGET_AVX2 static inline Vector Load(const void *pos) {
+            return _mm256_loadu_pd(static_cast<const double *>(pos));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline Vector Set1(const void *value) {
+            return _mm256_set1_pd(*static_cast<const double *>(value));
+        }
+
+        ESCAPIST_TARGET_AVX2 static inline unsigned EqualMask(Vector left, Vector right) {
+            return unsigned(_mm256_movemask_epi8(_mm256_castpd_si256(_mm256_cmp_pd(left, right, _CMP_EQ_OQ))));
+        }
+    };
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 const T *FindAvx2(const T *first, const T *last, const T &value) {
+        using Ops = Avx2Ops<sizeof(T), std::is_floating_point<T>::value>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        auto needle = Ops::Set1(&value);
+        for (; SizeType(last - first) >= kLanes; first += kLanes) {
+            if (unsigned mask = Ops::EqualMask(Ops::Load(first), needle)) {
+                return first + CountTrailingZeros(mask) / sizeof(T);
+            }
+        }
+        return FindScalar(first, last, value);
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 const T *ReverseFindAvx2(const T *first, const T *last, const T &value) {
+        using Ops = Avx2Ops<sizeof(T), std::is_floating_point<T>::value>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        auto needle = Ops::Set1(&value);
+        for (; SizeType(last - first) >= kLanes;) {
+            last -= kLanes;
+            if (unsigned mask = Ops::EqualMask(Ops::Load(last), needle)) {
+                return last + HighestBit(mask) / sizeof(T);
+            }
+        }
+        return ReverseFindScalar(first, last, value);
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 SizeType CountAvx2(const T *first, const T *last, const T &value) {
+        using Ops = Avx2Ops<sizeof(T), std::is_floating_point<T>::value>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        auto needle = Ops::Set1(&value);
+        SizeType bits = 0;
+        for (; SizeType(last - first) >= kLanes; first += kLanes) {
+            bits += PopCount(Ops::EqualMask(Ops::Load(first), needle));
+        }
+        return bits / sizeof(T) + CountScalar(first, last, value);
+    }
+#endif
+
+    /**
+     * Arithmetic Pod elements compare equal exactly when the SIMD compare says so.
+     */
+    template<typename T>
+    struct SimdSearchable {
+        static constexpr bool value = TypeTraitPatternDefiner<T>::Pattern == TypeTraitPattern::Pod &&
+                                      std::is_arithmetic<T>::value &&
+                                      (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+    };
+
+    /**
+     * Linear search of a single element in [first, last).
+     * Elements which are not SimdSearchable are compared by \p Trait::Equals.
+     */
+    template<typename T, typename Trait, bool = SimdSearchable<T>::value>
+    struct ElementSearch {
+        static const T *Find(const T *first, const T *last, const T &value) {
+            for (; first != last; ++first) {
+                if (Trait::Equals(*first, value)) {
+                    return first;
+                }
+            }
+            return nullptr;
+        }
+
+        static const T *ReverseFind(const T *first, const T *last, const T &value) {
+            while (last != first) {
+                if (Trait::Equals(*--last, value)) {
+                    return last;
+                }
+            }
+            return nullptr;
+        }
+
+        static SizeType Count(const T *first, const T *last, const T &value) {
+            SizeType rtn = 0;
+            for (; first != last; ++first) {
+                rtn += Trait::Equals(*first, value);
+            }
+            return rtn;
+        }
+    };
+
+    template<typename T, typename Trait>
+    struct ElementSearch<T, Trait, true> {
+        static const T *Find(const T *first, const T *last, const T &value) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return FindAvx2(first, last, value);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            return FindSse2(first, last, value);
+#else
+            return FindScalar(first, last, value);
+#endif
+        }
+
+        static const T *ReverseFind(const T *first, const T *last, const T &value) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return ReverseFindAvx2(first, last, value);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            return ReverseFindSse2(first, last, value);
+#else
+            return ReverseFindScalar(first, last, value);
+#endif
+        }
+
+        static SizeType Count(const T *first, const T *last, const T &value) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return CountAvx2(first, last, value);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            return CountSse2(first, last, value);
+#else
+            return CountScalar(first, last, value);
+#endif
+        }
+    };
+
+    constexpr SizeType kPageSize = 4096;
+
+    /**
+     * @return true if \p bytes bytes from \p pos lie on a single page,
+     *         thus reading them cannot fault as long as the first one is readable.
+     */
+    inline bool WithinPage(const void *pos, SizeType bytes) {
+        return (reinterpret_cast<std::uintptr_t>(pos) & (kPageSize - 1)) <= kPageSize - bytes;
+    }
+
+    template<typename T>
+    inline int CompareUnit(const T &left, const T &right) {
+        return left < right ? -1 : (left > right ? 1 : 0);
+    }
+
+    /**
+     * @return the first element of the null-terminated \p src equal to \p value, or the terminator
+     */
+    template<typename T>
+    inline const T *ScanScalar(const T *src, const T &value) {
+        for (; *src && !(*src == value); ++src);
+        return src;
+    }
+
+    /**
+     * @return the first element among the initial \p count of \p src equal to \p value or zero, nullptr if none
+     */
+    template<typename T>
+    inline const T *ScanScalar(const T *src, const T &value, SizeType count) {
+        for (; count; ++src, --count) {
+            if (!*src || *src == value) {
+                return src;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Compares at most \p count elements of two null-terminated strings.
+     */
+    template<typename T>
+    inline int CompareScalar(const T *left, const T *right, SizeType count) {
+        for (; count; ++left, ++right, --count) {
+            if (!(*left == *right) || !*left) {
+                return CompareUnit(*left, *right);
+            }
+        }
+        return 0;
+    }
+
+    template<typename T>
+    inline void FillScalar(T *dest, const T &value, SizeType count) {
+        for (; count; ++dest, --count) {
+            *dest = value;
+        }
+    }
+
+#ifdef ESCAPIST_SIMD_SSE2
+    /**
+     * Aligned loads starting from the block holding \p src, thus every load stays on a readable page.
+     */
+    template<typename T>
+    ESCAPIST_NO_SANITIZE_ADDRESS const T *ScanSse2(const T *src, const T &value) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        const T zero_value = T();
+        auto needle = Ops::Set1(&value), zero = Ops::Set1(&zero_value);
+        SizeType misalign = reinterpret_cast<std::uintptr_t>(src) & 15;
+        const T *pos = reinterpret_cast<const T *>(reinterpret_cast<const unsigned char *>(src) - misalign);
+        auto block = Ops::LoadAligned(pos);
+        if (unsigned mask = (Ops::EqualMask(block, needle) | Ops::EqualMask(block, zero)) >> misalign) {
+            return src + CountTrailingZeros(mask) / sizeof(T);
+        }
+        for (;;) {
+            pos += 16 / sizeof(T);
+            block = Ops::LoadAligned(pos);
+            if (unsigned mask = Ops::EqualMask(block, needle) | Ops::EqualMask(block, zero)) {
+                return pos + CountTrailingZeros(mask) / sizeof(T);
+            }
+        }
+    }
+
+    template<typename T>
+    ESCAPIST_NO_SANITIZE_ADDRESS const T *ScanSse2(const T *src, const T &value, SizeType count) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        const T zero_value = T();
+        auto needle = Ops::Set1(&value), zero = Ops::Set1(&zero_value);
+        while (count) {
+            if (count >= kLanes && WithinPage(src, 16)) {
+                auto block = Ops::Load(src);
+                if (unsigned mask = Ops::EqualMask(block, needle) | Ops::EqualMask(block, zero)) {
+                    return src + CountTrailingZeros(mask) / sizeof(T);
+                }
+                src += kLanes, count -= kLanes;
+            } else {
+                if (!*src || *src == value) {
+                    return src;
+                }
+                ++src, --count;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    ESCAPIST_NO_SANITIZE_ADDRESS int CompareSse2(const T *left, const T *right, SizeType count) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        const T zero_value = T();
+        auto zero = Ops::Set1(&zero_value);
+        while (count) {
+            if (count >= kLanes && WithinPage(left, 16) && WithinPage(right, 16)) {
+                auto block = Ops::Load(left);
+                // stop at the first difference or terminator.
+                if (unsigned mask = (~Ops::EqualMask(block, Ops::Load(right)) | Ops::EqualMask(block, zero)) & 0xFFFFu) {
+                    SizeType index = CountTrailingZeros(mask) / sizeof(T);
+                    return CompareUnit(left[index], right[index]);
+                }
+                left += kLanes, right += kLanes, count -= kLanes;
+            } else {
+                if (!(*left == *right) || !*left) {
+                    return CompareUnit(*left, *right);
+                }
+                ++left, ++right, --count;
+            }
+        }
+        return 0;
+    }
+
+    template<typename T>
+    void FillSse2(T *dest, const T &value, SizeType count) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        auto block = Ops::Set1(&value);
+        for (; count >= kLanes; dest += kLanes, count -= kLanes) {
+            Ops::Store(dest, block);
+        }
+        FillScalar(dest, value, count);
+    }
+#endif
+
+#ifdef ESCAPIST_SIMD_AVX2
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 ESCAPIST_NO_SANITIZE_ADDRESS const T *ScanAvx2(const T *src, const T &value) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        const T zero_value = T();
+        auto needle = Ops::Set1(&value), zero = Ops::Set1(&zero_value);
+        SizeType misalign = reinterpret_cast<std::uintptr_t>(src) & 31;
+        const T *pos = reinterpret_cast<const T *>(reinterpret_cast<const unsigned char *>(src) - misalign);
+        auto block = Ops::LoadAligned(pos);
+        if (unsigned mask = (Ops::EqualMask(block, needle) | Ops::EqualMask(block, zero)) >> misalign) {
+            return src + CountTrailingZeros(mask) / sizeof(T);
+        }
+        for (;;) {
+            pos += 32 / sizeof(T);
+            block = Ops::LoadAligned(pos);
+            if (unsigned mask = Ops::EqualMask(block, needle) | Ops::EqualMask(block, zero)) {
+                return pos + CountTrailingZeros(mask) / sizeof(T);
+            }
+        }
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 ESCAPIST_NO_SANITIZE_ADDRESS const T *ScanAvx2(const T *src, const T &value, SizeType count) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        const T zero_value = T();
+        auto needle = Ops::Set1(&value), zero = Ops::Set1(&zero_value);
+        while (count) {
+            if (count >= kLanes && WithinPage(src, 32)) {
+                auto block = Ops::Load(src);
+                if (unsigned mask = Ops::EqualMask(block, needle) | Ops::EqualMask(block, zero)) {
+                    return src + CountTrailingZeros(mask) / sizeof(T);
+                }
+                src += kLanes, count -= kLanes;
+            } else {
+                if (!*src || *src == value) {
+                    return src;
+                }
+                ++src, --count;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 ESCAPIST_NO_SANITIZE_ADDRESS int CompareAvx2(const T *left, const T *right, SizeType count) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        const T zero_value = T();
+        auto zero = Ops::Set1(&zero_value);
+        while (count) {
+            if (count >= kLanes && WithinPage(left, 32) && WithinPage(right, 32)) {
+                auto block = Ops::Load(left);
+                if (unsigned mask = ~Ops::EqualMask(block, Ops::Load(right)) | Ops::EqualMask(block, zero)) {
+                    SizeType index = CountTrailingZeros(mask) / sizeof(T);
+                    return CompareUnit(left[index], right[index]);
+                }
+                left += kLanes, right += kLanes, count -= kLanes;
+            } else {
+                if (!(*left == *right) || !*left) {
+                    return CompareUnit(*left, *right);
+                }
+                ++left, ++right, --count;
+            }
+        }
+        return 0;
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 void FillAvx2(T *dest, const T &value, SizeType count) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        auto block = Ops::Set1(&value);
+        for (; count >= kLanes; dest += kLanes, count -= kLanes) {
+            Ops::Store(dest, block);
+        }
+        FillScalar(dest, value, count);
+    }
+#endif
+
+    /**
+     * Integral code units of 1, 2 or 4 bytes, such as char16_t and char32_t.
+     */
+    template<typename Ch>
+    struct SimdCharUnit {
+        static constexpr bool value = std::is_integral<Ch>::value &&
+                                      (sizeof(Ch) == 1 || sizeof(Ch) == 2 || sizeof(Ch) == 4);
+    };
+
+    /**
+     * Kernels behind the generic ICharTrait, working on null-terminated strings of code units.
+     */
+    template<typename Ch, bool = SimdCharUnit<Ch>::value>
+    struct CharKernel {
+        static const Ch *Scan(const Ch *src, const Ch &value) {
+            return ScanScalar(src, value);
+        }
+
+        static const Ch *Scan(const Ch *src, const Ch &value, SizeType count) {
+            return ScanScalar(src, value, count);
+        }
+
+        static int Compare(const Ch *left, const Ch *right, SizeType count) {
+            return CompareScalar(left, right, count);
+        }
+
+        static void Fill(Ch *dest, const Ch &value, SizeType count) {
+            FillScalar(dest, value, count);
+        }
+    };
+
+    template<typename Ch>
+    struct CharKernel<Ch, true> {
+        static const Ch *Scan(const Ch *src, const Ch &value) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return ScanAvx2(src, value);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            return ScanSse2(src, value);
+#else
+            return ScanScalar(src, value);
+#endif
+        }
+
+        static const Ch *Scan(const Ch *src, const Ch &value, SizeType count) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return ScanAvx2(src, value, count);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            return ScanSse2(src, value, count);
+#else
+            return ScanScalar(src, value, count);
+#endif
+        }
+
+        static int Compare(const Ch *left, const Ch *right, SizeType count) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return CompareAvx2(left, right, count);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            return CompareSse2(left, right, count);
+#else
+            return CompareScalar(left, right, count);
+#endif
+        }
+
+        static void Fill(Ch *dest, const Ch &value, SizeType count) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return FillAvx2(dest, value, count);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            FillSse2(dest, value, count);
+#else
+            FillScalar(dest, value, count);
+#endif
+        }
+    };
+
+    /**
+     * Clears the bits of the element at \p index in a byte mask.
+     */
+    template<typename T>
+    inline unsigned ClearElement(unsigned mask, SizeType index) {
+        return mask & ~(((1u << sizeof(T)) - 1) << (index * sizeof(T)));
+    }
+
+    template<typename T>
+    inline bool UnitsEqual(const T *left, const T *right, SizeType count) {
+        return !count || !::memcmp(left, right, count * sizeof(T));
+    }
+
+#ifdef ESCAPIST_SIMD_SSE2
+    /**
+     * Substring filter: a block of starting positions is kept only where both the first and the last
+     * character of the needle match, the survivors are verified by memcmp.
+     * @param len the length of the needle, at least 2
+     */
+    template<typename T>
+    const T *FilterFindSse2(const T *first, const T *last, const T *needle, SizeType len) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        auto head = Ops::Set1(needle), tail = Ops::Set1(needle + len - 1);
+        const T *pos = first;
+        for (; SizeType(last - pos) >= kLanes + len - 1; pos += kLanes) {
+            unsigned mask = Ops::EqualMask(Ops::Load(pos), head) & Ops::EqualMask(Ops::Load(pos + len - 1), tail);
+            for (; mask; ) {
+                SizeType index = CountTrailingZeros(mask) / sizeof(T);
+                if (UnitsEqual(pos + index + 1, needle + 1, len - 2)) {
+                    return pos + index;
+                }
+                mask = ClearElement<T>(mask, index);
+            }
+        }
+        for (; SizeType(last - pos) >= len; ++pos) {
+            if (*pos == *needle && UnitsEqual(pos + 1, needle + 1, len - 1)) {
+                return pos;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    const T *FilterReverseFindSse2(const T *first, const T *last, const T *needle, SizeType len) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        auto head = Ops::Set1(needle), tail = Ops::Set1(needle + len - 1);
+        const T *pos = last - (len - 1); // one past the last starting position.
+        for (; SizeType(pos - first) >= kLanes;) {
+            pos -= kLanes;
+            unsigned mask = Ops::EqualMask(Ops::Load(pos), head) & Ops::EqualMask(Ops::Load(pos + len - 1), tail);
+            for (; mask; ) {
+                SizeType index = HighestBit(mask) / sizeof(T);
+                if (UnitsEqual(pos + index + 1, needle + 1, len - 2)) {
+                    return pos + index;
+                }
+                mask = ClearElement<T>(mask, index);
+            }
+        }
+        while (pos != first) {
+            if (*--pos == *needle && UnitsEqual(pos + 1, needle + 1, len - 1)) {
+                return pos;
+            }
+        }
+        return nullptr;
+    }
+#endif
+
+#ifdef ESCAPIST_SIMD_AVX2
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 const T *FilterFindAvx2(const T *first, const T *last, const T *needle, SizeType len) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        auto head = Ops::Set1(needle), tail = Ops::Set1(needle + len - 1);
+        const T *pos = first;
+        for (; SizeType(last - pos) >= kLanes + len - 1; pos += kLanes) {
+            unsigned mask = Ops::EqualMask(Ops::Load(pos), head) & Ops::EqualMask(Ops::Load(pos + len - 1), tail);
+            for (; mask; ) {
+                SizeType index = CountTrailingZeros(mask) / sizeof(T);
+                if (UnitsEqual(pos + index + 1, needle + 1, len - 2)) {
+                    return pos + index;
+                }
+                mask = ClearElement<T>(mask, index);
+            }
+        }
+        for (; SizeType(last - pos) >= len; ++pos) {
+            if (*pos == *needle && UnitsEqual(pos + 1, needle + 1, len - 1)) {
+                return pos;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 const T *FilterReverseFindAvx2(const T *first, const T *last, const T *needle, SizeType len) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        auto head = Ops::Set1(needle), tail = Ops::Set1(needle + len - 1);
+        const T *pos = last - (len - 1);
+        for (; SizeType(pos - first) >= kLanes;) {
+            pos -= kLanes;
+            unsigned mask = Ops::EqualMask(Ops::Load(pos), head) & Ops::EqualMask(Ops::Load(pos + len - 1), tail);
+            for (; mask; ) {
+                SizeType index = HighestBit(mask) / sizeof(T);
+                if (UnitsEqual(pos + index + 1, needle + 1, len - 2)) {
+                    return pos + index;
+                }
+                mask = ClearElement<T>(mask, index);
+            }
+        }
+        while (pos != first) {
+            if (*--pos == *needle && UnitsEqual(pos + 1, needle + 1, len - 1)) {
+                return pos;
+            }
+        }
+        return nullptr;
+    }
+#endif
+
+    /**
+     * The substring filter of short needles, available for SimdCharUnit types on x86.
+     * Both functions expect at least \p len characters in [first, last) and \p len >= 2.
+     */
+    template<typename Ch, bool = SimdCharUnit<Ch>::value>
+    struct SubstringFilter {
+        static constexpr bool kAvailable = false;
+
+        static const Ch *Find(const Ch *first, const Ch *last, const Ch *needle, SizeType len) {
+            return nullptr;
+        }
+
+        static const Ch *ReverseFind(const Ch *first, const Ch *last, const Ch *needle, SizeType len) {
+            return nullptr;
+        }
+    };
+
+#ifdef ESCAPIST_SIMD_SSE2
+    template<typename Ch>
+    struct SubstringFilter<Ch, true> {
+        static constexpr bool kAvailable = true;
+
+        static const Ch *Find(const Ch *first, const Ch *last, const Ch *needle, SizeType len) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return FilterFindAvx2(first, last, needle, len);
+            }
+#endif
+            return FilterFindSse2(first, last, needle, len);
+        }
+
+        static const Ch *ReverseFind(const Ch *first, const Ch *last, const Ch *needle, SizeType len) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return FilterReverseFindAvx2(first, last, needle, len);
+            }
+#endif
+            return FilterReverseFindSse2(first, last, needle, len);
+        }
+    };
+#endif
+
+    /**
+     * ASCII case folding: only 'A' to 'Z' and 'a' to 'z' are mapped, every other unit is kept,
+     * thus the result does not depend on the locale.
+     */
+    template<typename T>
+    inline T AsciiToLower(const T &ch) {
+        return ch >= T('A') && ch <= T('Z') ? T(ch + ('a' - 'A')) : ch;
+    }
+
+    template<typename T>
+    inline T AsciiToUpper(const T &ch) {
+        return ch >= T('a') && ch <= T('z') ? T(ch - ('a' - 'A')) : ch;
+    }
+
+    /**
+     * @return the index of the first unit where \p left and \p right differ after ASCII case folding,
+     *         or \p count if there is none
+     */
+    template<typename T>
+    inline SizeType FoldedMismatchScalar(const T *left, const T *right, SizeType count) {
+        SizeType index = 0;
+        for (; index < count && AsciiToLower(left[index]) == AsciiToLower(right[index]); ++index);
+        return index;
+    }
+
+    /**
+     * Flips the case of the units of [src, src + count) within [first, last],
+     * which is either 'A' to 'Z' or 'a' to 'z'. Cases differ in the bit 0x20 only.
+     */
+    template<typename T>
+    inline void FlipCaseScalar(T *src, SizeType count, const T &first, const T &last) {
+        for (; count; ++src, --count) {
+            if (*src >= first && *src <= last) {
+                *src = T(*src ^ T(0x20));
+            }
+        }
+    }
+
+#ifdef ESCAPIST_SIMD_SSE2
+    /**
+     * Flips the bit 0x20 of the lanes of \p block strictly between \p below and \p above.
+     */
+    template<typename Ops>
+    inline typename Ops::Vector FlipCaseBlockSse2(typename Ops::Vector block, typename Ops::Vector below,
+                                                  typename Ops::Vector above, typename Ops::Vector bit) {
+        auto within = _mm_and_si128(Ops::Greater(block, below), Ops::Greater(above, block));
+        return _mm_xor_si128(block, _mm_and_si128(within, bit));
+    }
+
+    template<typename T>
+    SizeType FoldedMismatchSse2(const T *left, const T *right, SizeType count) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        const T below_value = T('A' - 1), above_value = T('Z' + 1), bit_value = T(0x20);
+        auto below = Ops::Set1(&below_value), above = Ops::Set1(&above_value), bit = Ops::Set1(&bit_value);
+        SizeType index = 0;
+        for (; count - index >= kLanes; index += kLanes) {
+            auto l = FlipCaseBlockSse2<Ops>(Ops::Load(left + index), below, above, bit);
+            auto r = FlipCaseBlockSse2<Ops>(Ops::Load(right + index), below, above, bit);
+            if (unsigned mask = ~Ops::EqualMask(l, r) & 0xFFFFu) {
+                return index + CountTrailingZeros(mask) / sizeof(T);
+            }
+        }
+        return index + FoldedMismatchScalar(left + index, right + index, count - index);
+    }
+
+    template<typename T>
+    void FlipCaseSse2(T *src, SizeType count, const T &first, const T &last) {
+        using Ops = Sse2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 16 / sizeof(T);
+        const T below_value = T(first - 1), above_value = T(last + 1), bit_value = T(0x20);
+        auto below = Ops::Set1(&below_value), above = Ops::Set1(&above_value), bit = Ops::Set1(&bit_value);
+        for (; count >= kLanes; src += kLanes, count -= kLanes) {
+            Ops::Store(src, FlipCaseBlockSse2<Ops>(Ops::Load(src), below, above, bit));
+        }
+        FlipCaseScalar(src, count, first, last);
+    }
+#endif
+
+#ifdef ESCAPIST_SIMD_AVX2
+    template<typename Ops>
+    ESCAPIST_TARGET_AVX2 inline typename Ops::Vector FlipCaseBlockAvx2(typename Ops::Vector block,
+                                                                       typename Ops::Vector below,
+                                                                       typename Ops::Vector above,
+                                                                       typename Ops::Vector bit) {
+        auto within = _mm256_and_si256(Ops::Greater(block, below), Ops::Greater(above, block));
+        return _mm256_xor_si256(block, _mm256_and_si256(within, bit));
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 SizeType FoldedMismatchAvx2(const T *left, const T *right, SizeType count) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        const T below_value = T('A' - 1), above_value = T('Z' + 1), bit_value = T(0x20);
+        auto below = Ops::Set1(&below_value), above = Ops::Set1(&above_value), bit = Ops::Set1(&bit_value);
+        SizeType index = 0;
+        for (; count - index >= kLanes; index += kLanes) {
+            auto l = FlipCaseBlockAvx2<Ops>(Ops::Load(left + index), below, above, bit);
+            auto r = FlipCaseBlockAvx2<Ops>(Ops::Load(right + index), below, above, bit);
+            if (unsigned mask = ~Ops::EqualMask(l, r)) {
+                return index + CountTrailingZeros(mask) / sizeof(T);
+            }
+        }
+        return index + FoldedMismatchScalar(left + index, right + index, count - index);
+    }
+
+    template<typename T>
+    ESCAPIST_TARGET_AVX2 void FlipCaseAvx2(T *src, SizeType count, const T &first, const T &last) {
+        using Ops = Avx2Ops<sizeof(T), false>;
+        constexpr SizeType kLanes = 32 / sizeof(T);
+        const T below_value = T(first - 1), above_value = T(last + 1), bit_value = T(0x20);
+        auto below = Ops::Set1(&below_value), above = Ops::Set1(&above_value), bit = Ops::Set1(&bit_value);
+        for (; count >= kLanes; src += kLanes, count -= kLanes) {
+            Ops::Store(src, FlipCaseBlockAvx2<Ops>(Ops::Load(src), below, above, bit));
+        }
+        FlipCaseScalar(src, count, first, last);
+    }
+#endif
+
+    /**
+     * ASCII case kernels behind ICharTrait, working on ranges of code units.
+     */
+    template<typename Ch, bool = SimdCharUnit<Ch>::value>
+    struct AsciiCase {
+        static SizeType FoldedMismatch(const Ch *left, const Ch *right, SizeType count) {
+            return FoldedMismatchScalar(left, right, count);
+        }
+
+        static void ToLower(Ch *src, SizeType count) {
+            FlipCaseScalar(src, count, Ch('A'), Ch('Z'));
+        }
+
+        static void ToUpper(Ch *src, SizeType count) {
+            FlipCaseScalar(src, count, Ch('a'), Ch('z'));
+        }
+    };
+
+    template<typename Ch>
+    struct AsciiCase<Ch, true> {
+        static SizeType FoldedMismatch(const Ch *left, const Ch *right, SizeType count) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return FoldedMismatchAvx2(left, right, count);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            return FoldedMismatchSse2(left, right, count);
+#else
+            return FoldedMismatchScalar(left, right, count);
+#endif
+        }
+
+        static void ToLower(Ch *src, SizeType count) {
+            AsciiCase<Ch, true>::FlipCase(src, count, Ch('A'), Ch('Z'));
+        }
+
+        static void ToUpper(Ch *src, SizeType count) {
+            AsciiCase<Ch, true>::FlipCase(src, count, Ch('a'), Ch('z'));
+        }
+
+    private:
+        static void FlipCase(Ch *src, SizeType count, const Ch &first, const Ch &last) {
+#ifdef ESCAPIST_SIMD_AVX2
+            if (CpuSupportsAvx2()) {
+                return FlipCaseAvx2(src, count, first, last);
+            }
+#endif
+#ifdef ESCAPIST_SIMD_SSE2
+            FlipCaseSse2(src, count, first, last);
+#else
+            FlipCaseScalar(src, count, first, last);
+#endif
+        }
+    };
+}
+
+#endif //ESCAPIST_SIMD_H
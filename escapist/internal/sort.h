@@ -0,0 +1,435 @@
+#ifndef ESCAPIST_SORT_H
+#define ESCAPIST_SORT_H
+
+#include "../base.h"
+#include "type_trait.h"
+#include "compare.h"
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/**
+ * Ordering algorithms over a contiguous range [first, last).
+ * Elements are only ever relocated through TypeTrait::Move, thus they work for every
+ * type a container can hold, including types without assignment operators.
+ * Comparators are functors taken by template, so that calls can be inlined.
+ */
+namespace Internal {
+    // Ranges shorter than this are finished with insertion sort.
+    constexpr SizeType kInsertionSortThreshold = 16;
+    // Ranges of arithmetic Pod values at least this long are sorted by radix.
+    constexpr SizeType kRadixSortThreshold = 256;
+    // Ranges at least this long are split across threads.
+    constexpr SizeType kParallelSortThreshold = SizeType(1) << 16;
+
+    inline SizeType SortLog2(SizeType n) {
+        SizeType rtn = 0;
+        for (; n > 1; n >>= 1, ++rtn);
+        return rtn;
+    }
+
+    template<typename T, typename Trait>
+    inline void SortSwap(T *left, T *right) {
+        if (left != right) {
+            alignas(T) unsigned char hole[sizeof(T)];
+            Trait::Move(reinterpret_cast<T *>(hole), left, 1);
+            Trait::Move(left, right, 1);
+            Trait::Move(right, reinterpret_cast<T *>(hole), 1);
+        }
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void InsertionSort(T *first, T *last, Compare &compare) {
+        if (first == last) {
+            return;
+        }
+        alignas(T) unsigned char hole[sizeof(T)];
+        T *tmp = reinterpret_cast<T *>(hole);
+        for (T *curr = first + 1; curr < last; ++curr) {
+            if (compare(*curr, *(curr - 1))) {
+                Trait::Move(tmp, curr, 1);
+                T *pos = curr;
+                do {
+                    Trait::Move(pos, pos - 1, 1);
+                    --pos;
+                } while (pos != first && compare(*tmp, *(pos - 1)));
+                Trait::Move(pos, tmp, 1);
+            }
+        }
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void SiftDown(T *first, SizeType root, SizeType size, Compare &compare) {
+        for (;;) {
+            SizeType child = root * 2 + 1;
+            if (child >= size) {
+                return;
+            }
+            if (child + 1 < size && compare(first[child], first[child + 1])) {
+                ++child;
+            }
+            if (!compare(first[root], first[child])) {
+                return;
+            }
+            SortSwap<T, Trait>(first + root, first + child);
+            root = child;
+        }
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void MakeHeap(T *first, SizeType size, Compare &compare) {
+        for (SizeType i = size / 2; i > 0; --i) {
+            SiftDown<T, Trait>(first, i - 1, size, compare);
+        }
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void SortHeap(T *first, SizeType size, Compare &compare) {
+        for (; size > 1; --size) {
+            SortSwap<T, Trait>(first, first + size - 1);
+            SiftDown<T, Trait>(first, 0, size - 1, compare);
+        }
+    }
+
+    /**
+     * Places the smallest (middle - first) elements of [first, last) in order at the front.
+     */
+    template<typename T, typename Trait, typename Compare>
+    void PartialSort(T *first, T *middle, T *last, Compare &compare) {
+        SizeType k = middle - first;
+        if (!k) {
+            return;
+        }
+        MakeHeap<T, Trait>(first, k, compare);
+        for (T *curr = middle; curr < last; ++curr) {
+            if (compare(*curr, *first)) {
+                SortSwap<T, Trait>(curr, first);
+                SiftDown<T, Trait>(first, 0, k, compare);
+            }
+        }
+        SortHeap<T, Trait>(first, k, compare);
+    }
+
+    /**
+     * Moves the median of the first, middle and last element to \p first,
+     * and leaves an element no less than it at the end.
+     */
+    template<typename T, typename Trait, typename Compare>
+    void MedianToFirst(T *first, T *last, Compare &compare) {
+        T *a = first, *b = first + (last - first) / 2, *c = last - 1;
+        if (compare(*b, *a)) {
+            SortSwap<T, Trait>(a, b);
+        }
+        if (compare(*c, *b)) {
+            SortSwap<T, Trait>(b, c);
+            if (compare(*b, *a)) {
+                SortSwap<T, Trait>(a, b);
+            }
+        }
+        SortSwap<T, Trait>(a, b);
+    }
+
+    /**
+     * Partitions [first, last) around the pivot at \p first.
+     * Both scans stop at elements equal to the pivot, which keeps ranges of
+     * equal elements balanced.
+     * @return the final position of the pivot
+     */
+    template<typename T, typename Trait, typename Compare>
+    T *Partition(T *first, T *last, Compare &compare) {
+        T *left = first, *right = last;
+        for (;;) {
+            while (compare(*++left, *first)) {
+                if (left == last - 1) {
+                    break;
+                }
+            }
+            while (compare(*first, *--right)) {
+                if (right == first) {
+                    break;
+                }
+            }
+            if (left >= right) {
+                break;
+            }
+            SortSwap<T, Trait>(left, right);
+        }
+        SortSwap<T, Trait>(first, right);
+        return right;
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void IntroSortLoop(T *first, T *last, SizeType depth, Compare &compare) {
+        while (SizeType(last - first) > kInsertionSortThreshold) {
+            if (!depth) { // quicksort is going quadratic, fall back to heap sort.
+                PartialSort<T, Trait>(first, last, last, compare);
+                return;
+            }
+            --depth;
+            MedianToFirst<T, Trait>(first, last, compare);
+            T *cut = Partition<T, Trait>(first, last, compare);
+            if (cut - first < last - cut) { // recurse on the smaller side to bound the stack.
+                IntroSortLoop<T, Trait>(first, cut, depth, compare);
+                first = cut + 1;
+            } else {
+                IntroSortLoop<T, Trait>(cut + 1, last, depth, compare);
+                last = cut;
+            }
+        }
+        InsertionSort<T, Trait>(first, last, compare);
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void IntroSort(T *first, T *last, Compare &compare) {
+        IntroSortLoop<T, Trait>(first, last, SortLog2(last - first) * 2, compare);
+    }
+
+    /**
+     * Rearranges [first, last) so that \p nth holds the element it would hold if sorted,
+     * with no greater element before it and no smaller element after it.
+     */
+    template<typename T, typename Trait, typename Compare>
+    void NthElement(T *first, T *nth, T *last, Compare &compare) {
+        SizeType depth = SortLog2(last - first) * 2;
+        while (SizeType(last - first) > kInsertionSortThreshold) {
+            if (!depth) {
+                PartialSort<T, Trait>(first, nth + 1, last, compare);
+                return;
+            }
+            --depth;
+            MedianToFirst<T, Trait>(first, last, compare);
+            T *cut = Partition<T, Trait>(first, last, compare);
+            if (cut == nth) {
+                return;
+            } else if (nth < cut) {
+                last = cut;
+            } else {
+                first = cut + 1;
+            }
+        }
+        InsertionSort<T, Trait>(first, last, compare);
+    }
+
+    /**
+     * Merges the sorted runs [first, middle) and [middle, last).
+     * @param buffer uninitialized room for at least (middle - first) elements
+     */
+    template<typename T, typename Trait, typename Compare>
+    void Merge(T *first, T *middle, T *last, T *buffer, Compare &compare) {
+        Trait::Move(buffer, first, middle - first);
+        T *left = buffer, *left_end = buffer + (middle - first), *right = middle, *out = first;
+        while (left != left_end && right != last) {
+            if (compare(*right, *left)) {
+                Trait::Move(out++, right++, 1);
+            } else {
+                Trait::Move(out++, left++, 1);
+            }
+        }
+        Trait::Move(out, left, left_end - left); // the rest of the right run is already in place.
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void MergeSort(T *first, T *last, T *buffer, Compare &compare) {
+        SizeType size = last - first;
+        if (size <= kInsertionSortThreshold) {
+            InsertionSort<T, Trait>(first, last, compare);
+            return;
+        }
+        T *middle = first + size / 2;
+        MergeSort<T, Trait>(first, middle, buffer, compare);
+        MergeSort<T, Trait>(middle, last, buffer, compare);
+        if (compare(*middle, *(middle - 1))) {
+            Merge<T, Trait>(first, middle, last, buffer, compare);
+        }
+    }
+
+    /**
+     * Sorts both halves on different threads, then merges them.
+     * @param buffer uninitialized room for (last - first) elements
+     * @param depth the amount of times the range may still be split
+     */
+    template<typename T, typename Trait, typename Compare>
+    void ParallelMergeSort(T *first, T *last, T *buffer, SizeType depth, bool stable, Compare &compare) {
+        SizeType size = last - first;
+        if (!depth || size < kParallelSortThreshold) {
+            if (stable) {
+                MergeSort<T, Trait>(first, last, buffer, compare);
+            } else {
+                IntroSort<T, Trait>(first, last, compare);
+            }
+            return;
+        }
+        T *middle = first + size / 2;
+        Compare other = compare; // every thread gets its own comparator.
+        std::thread worker([=, &other]() {
+            ParallelMergeSort<T, Trait>(first, middle, buffer, depth - 1, stable, other);
+        });
+        ParallelMergeSort<T, Trait>(middle, last, buffer + (middle - first), depth - 1, stable, compare);
+        worker.join();
+        if (compare(*middle, *(middle - 1))) {
+            Merge<T, Trait>(first, middle, last, buffer, compare);
+        }
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void StableSort(T *first, T *last, Compare &compare) {
+        SizeType size = last - first;
+        if (size <= kInsertionSortThreshold) {
+            InsertionSort<T, Trait>(first, last, compare);
+            return;
+        }
+        SizeType threads = std::thread::hardware_concurrency();
+        bool parallel = threads > 1 && size >= kParallelSortThreshold * 2;
+        T *buffer = static_cast<T *>(::malloc((parallel ? size : size / 2 + 1) * sizeof(T)));
+        assert(buffer);
+        if (parallel) {
+            ParallelMergeSort<T, Trait>(first, last, buffer, SortLog2(threads), true, compare);
+        } else {
+            MergeSort<T, Trait>(first, last, buffer, compare);
+        }
+        ::free(buffer);
+    }
+
+    template<typename T, typename Trait, typename Compare>
+    void Sort(T *first, T *last, Compare &compare) {
+        SizeType size = last - first;
+        SizeType threads = std::thread::hardware_concurrency();
+        if (threads > 1 && size >= kParallelSortThreshold * 2) {
+            T *buffer = static_cast<T *>(::malloc(size * sizeof(T)));
+            assert(buffer);
+            ParallelMergeSort<T, Trait>(first, last, buffer, SortLog2(threads), false, compare);
+            ::free(buffer);
+        } else {
+            IntroSort<T, Trait>(first, last, compare);
+        }
+    }
+
+    template<SizeType Size>
+    struct RadixUnsigned;
+
+    template<>
+    struct RadixUnsigned<1> {
+        using Type = unsigned char;
+    };
+
+    template<>
+    struct RadixUnsigned<2> {
+        using Type = unsigned short;
+    };
+
+    template<>
+    struct RadixUnsigned<4> {
+        using Type = unsigned int;
+    };
+
+    template<>
+    struct RadixUnsigned<8> {
+        using Type = unsigned long long;
+    };
+
+    /**
+     * Maps an arithmetic value to an unsigned key with the same ascending order.
+     * Values equal under LessThan get equal keys, thus -0.0 shares the key of +0.0.
+     */
+    template<typename T>
+    inline typename RadixUnsigned<sizeof(T)>::Type RadixKey(const T &value) {
+        using U = typename RadixUnsigned<sizeof(T)>::Type;
+        constexpr U sign = U(U(1) << (sizeof(T) * 8 - 1));
+        U bits;
+        ::memcpy(&bits, &value, sizeof(T));
+        if (std::is_floating_point<T>::value) {
+            if (bits == sign) { // -0.0
+                return sign;
+            }
+            return (bits & sign) ? U(~bits) : U(bits | sign);
+        } else if (std::is_signed<T>::value) {
+            return U(bits ^ sign);
+        }
+        return bits;
+    }
+
+    /**
+     * LSD radix sort, one byte per pass. Passes where every key has the same digit are skipped.
+     * It is stable, thus it serves both Sort and StableSort.
+     */
+    template<typename T>
+    void RadixSort(T *first, T *last) {
+        SizeType size = last - first;
+        SizeType count[sizeof(T)][256] = {};
+        for (T *curr = first; curr != last; ++curr) {
+            auto key = RadixKey(*curr);
+            for (SizeType byte = 0; byte < sizeof(T); ++byte) {
+                ++count[byte][(key >> (byte * 8)) & 0xFF];
+            }
+        }
+        T *buffer = static_cast<T *>(::malloc(size * sizeof(T)));
+        assert(buffer);
+        T *src = first, *dest = buffer;
+        for (SizeType byte = 0; byte < sizeof(T); ++byte) {
+            SizeType *digit_count = count[byte];
+            if (digit_count[(RadixKey(*src) >> (byte * 8)) & 0xFF] == size) {
+                continue;
+            }
+            SizeType offset = 0;
+            for (SizeType digit = 0; digit < 256; ++digit) {
+                SizeType c = digit_count[digit];
+                digit_count[digit] = offset;
+                offset += c;
+            }
+            for (T *curr = src, *end = src + size; curr != end; ++curr) {
+                dest[digit_count[(RadixKey(*curr) >> (byte * 8)) & 0xFF]++] = *curr;
+            }
+            T *tmp = src;
+            src = dest;
+            dest = tmp;
+        }
+        if (src != first) {
+            ::memcpy(first, src, size * sizeof(T));
+        }
+        ::free(buffer);
+    }
+
+    /**
+     * Radix sort applies to arithmetic types marked Pod which are ordered by the default comparator.
+     */
+    template<typename T, typename Compare>
+    struct RadixSortable {
+        static constexpr bool value = std::is_same<Compare, LessThan<T>>::value &&
+                                      std::is_arithmetic<T>::value &&
+                                      TypeTraitPatternDefiner<T>::Pattern == TypeTraitPattern::Pod &&
+                                      (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+    };
+
+    template<typename T, typename Trait, typename Compare, bool = RadixSortable<T, Compare>::value>
+    struct Sorter {
+        static void Sort(T *first, T *last, Compare &compare) {
+            Internal::Sort<T, Trait>(first, last, compare);
+        }
+
+        static void StableSort(T *first, T *last, Compare &compare) {
+            Internal::StableSort<T, Trait>(first, last, compare);
+        }
+    };
+
+    template<typename T, typename Trait, typename Compare>
+    struct Sorter<T, Trait, Compare, true> {
+        static void Sort(T *first, T *last, Compare &compare) {
+            if (SizeType(last - first) >= kRadixSortThreshold) {
+                RadixSort(first, last);
+            } else {
+                IntroSort<T, Trait>(first, last, compare);
+            }
+        }
+
+        static void StableSort(T *first, T *last, Compare &compare) {
+            if (SizeType(last - first) >= kRadixSortThreshold) {
+                RadixSort(first, last);
+            } else {
+                Internal::StableSort<T, Trait>(first, last, compare);
+            }
+        }
+    };
+}
+
+#endif //ESCAPIST_SORT_H
@@ -5,15 +5,32 @@
 #include <cstring>
 #include <cstdlib>
 #include <type_traits>
-
+#include <utility>
+
+/**
+ * The set of operations containers use to handle their elements.
+ *  - Copy: copy-constructs \p count elements into uninitialized \p dest.
+ *  - Move: relocates \p count elements from \p src to \p dest. Both ranges may overlap.
+ *          After the call, \p dest holds the elements and the slots of \p src that are
+ *          not covered by \p dest are uninitialized again, as if they had been destroyed.
+ *  - Assign: constructs a copy of \p v at uninitialized \p dest, or moves \p v there if it is an rvalue.
+ *  - Equals: compares two elements.
+ *  - Destroy: destructs the element at \p dest.
+ * \c kRelocatable tells whether the elements may be moved around by bitwise copy,
+ * such as ::realloc.
+ */
 template<typename T>
 struct TypeTrait {
+    static constexpr bool kRelocatable = false;
+
     static void Copy(T *dest, const T *src, SizeType count);
 
-    static void Move(T *dest, const T *src, SizeType count);
+    static void Move(T *dest, T *src, SizeType count);
 
     static void Assign(T *dest, const T &v);
 
+    static void Assign(T *dest, T &&v);
+
     static bool Equals(const T &left, const T &right);
 
     static void Destroy(T *dest);
@@ -22,11 +39,13 @@ struct TypeTrait {
 namespace Internal {
     template<typename T>
     struct PodTypeTrait : public TypeTrait<T> {
+        static constexpr bool kRelocatable = true;
+
         static inline void Copy(T *dest, const T *src, SizeType count) {
             ::memcpy(dest, src, count * sizeof(T));
         }
 
-        static void Move(T *dest, const T *src, SizeType count) {
+        static void Move(T *dest, T *src, SizeType count) {
             ::memmove(dest, src, count * sizeof(T));
         }
 
@@ -34,6 +53,10 @@ namespace Internal {
             new(dest)T(v);
         }
 
+        static void Assign(T *dest, T &&v) {
+            new(dest)T(std::move(v));
+        }
+
         static bool Equals(const T &left, const T &right) {
             return (left == right);
         }
@@ -43,22 +66,35 @@ namespace Internal {
 
     template<typename T>
     struct GenericTypeTrait : public TypeTrait<T> {
+        static constexpr bool kRelocatable = false;
+
         static inline void Copy(T *dest, const T *src, SizeType count) {
             for (; count > 0; ++dest, ++src, --count) {
                 new(dest)T(*src);
             }
         }
 
-        static void Move(T *dest, const T *src, SizeType count) {
-            if (dest <= src || dest >= (src + count)) {
-                for (; count > 0; ++dest, ++src, --count)
-                    new(dest)T(*src);
+        /**
+         * Move-constructs every element at its new place and destroys the source right after,
+         * thus a slot of \p dest overlapping \p src has always been vacated before it is reused.
+         */
+        static void Move(T *dest, T *src, SizeType count) {
+            if (dest == src) {
+                return;
+            }
+            if (dest < src || dest >= (src + count)) {
+                for (; count > 0; ++dest, ++src, --count) {
+                    new(dest)T(std::move(*src));
+                    src->~T();
+                }
             } else {
                 dest = dest + count - 1;
                 src = src + count - 1;
 
-                for (; count > 0; --dest, --src, --count)
-                    new(dest)T(*src);
+                for (; count > 0; --dest, --src, --count) {
+                    new(dest)T(std::move(*src));
+                    src->~T();
+                }
             }
         }
 
@@ -66,6 +102,10 @@ namespace Internal {
             new(dest)T(v);
         }
 
+        static void Assign(T *dest, T &&v) {
+            new(dest)T(std::move(v));
+        }
+
         static bool Equals(const T &left, const T &right) {
             return left == right;
         }
@@ -75,14 +115,30 @@ namespace Internal {
         }
     };
 
+    /**
+     * For types whose object representation does not depend on its address,
+     * such as \c BasicString and \c List, which only hold pointers to their heap blocks.
+     * Copies and destructions still run the constructors and destructors,
+     * but moving them around is a plain ::memmove.
+     */
+    template<typename T>
+    struct RelocatableTypeTrait : public GenericTypeTrait<T> {
+        static constexpr bool kRelocatable = true;
+
+        static void Move(T *dest, T *src, SizeType count) {
+            ::memmove(static_cast<void *>(dest), static_cast<const void *>(src), count * sizeof(T));
+        }
+    };
+
     enum class TypeTraitPattern : short {
         Pod,
         Generic,
+        Relocatable,
         NonDefault
     };
 
     template<typename T>
-    constexpr bool TypeTraitPatternAutoDefiner = !std::is_arithmetic<T>::value;
+    constexpr bool TypeTraitPatternAutoDefiner = !std::is_trivially_copyable<T>::value;
 
     template<typename T>
     struct TypeTraitPatternDefiner {
@@ -107,6 +163,12 @@ namespace Internal {
         using Type = Internal::GenericTypeTrait<T>;
     };
 
+    template<typename T>
+    struct TypeTraitPatternSelector<T,
+            typename std::enable_if<(TypeTraitPatternDefiner<T>::Pattern == TypeTraitPattern::Relocatable)>::type> {
+        using Type = Internal::RelocatableTypeTrait<T>;
+    };
+
     template<typename T>
     struct TypeTraitPatternSelector<T,
             typename std::enable_if<(TypeTraitPatternDefiner<T>::Pattern == TypeTraitPattern::NonDefault)>::type> {
@@ -123,6 +185,7 @@ struct Internal::TypeTraitPatternDefiner<T>\
 }
 #define DefinePodTypeTrait(T) DefineTypeTrait(T,Internal::TypeTraitPattern::Pod)
 #define DefineGenericTypeTrait(T) DefineTypeTrait(T,Internal::TypeTraitPattern::Generic)
+#define DefineRelocatableTypeTrait(T) DefineTypeTrait(T,Internal::TypeTraitPattern::Relocatable)
 #define DefineNonDefaultTypeTrait(T) DefineTypeTrait(T,Internal::TypeTraitPattern::NonDefault)
 
 DefinePodTypeTrait(bool);
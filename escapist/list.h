@@ -4,154 +4,145 @@
 // TODO: Introduction
 
 #include <initializer_list>
+#include <utility>
 #include "base.h"
-#include "internal/ref_count.h"
+#include "thread_policy.h"
+#include "allocator.h"
+#include "growth.h"
 #include "internal/type_trait.h"
-
-template<typename T>
+#include "internal/checked_pointer.h"
+#include "internal/sort.h"
+#include "internal/hash.h"
+#include "internal/simd.h"
+
+/**
+ * @tparam T the type of elements
+ * @tparam Allocator the allocation policy of the memory block, see allocator.h
+ * @tparam Growth the growth policy deciding the capacity of a new block, see growth.h
+ * @tparam Thread the thread policy of the shared block, see thread_policy.h
+ */
+template<typename T, typename Allocator = MallocAllocator, typename Growth = HalfGrowth,
+         typename Thread = MultiThreadPolicy>
 class List {
 public:
     /**
-     *
+     * An iterator over the elements, which remembers its index and its list so that it can check its bounds.
+     * It models IIterator, see base.h.
      */
-    class Iterator {
+    class Iterator : public IIterator<Iterator, T> {
     public:
         Iterator() = delete;
 
-        Iterator(const Iterator &other) noexcept
-                : pos_(other.pos_), index_(other.index_), from_(other.from_) {}
-
-        Iterator(Iterator &&other) noexcept
-                : pos_(other.pos_), index_(other.index_), from_(other.from_) {
-            other.pos_ = other.index_ = other.from_ = 0;
-        }
-
-        List<T>::Iterator &operator=(const List<T>::Iterator &other) {
-            if (this == &other) {
-                return *this;
-            }
-            new(this)List<T>::Iterator(other.pos_, other.index_, other.from_);
+        T &Instance() const noexcept {
+            return *pos_;
         }
 
-        bool operator==(const List<T>::Iterator &other) const noexcept {
+        bool Equals(const List::Iterator &other) const noexcept {
             return from_->data_ == other.from_->data_ && pos_ == other.pos_;
         }
 
-        bool operator!=(const List<T>::Iterator &other) const noexcept {
-            return !(from_->data_ == other.from_->data_ && pos_ == other.pos_);
-        }
-
-        T &Instance() noexcept {
-            return *pos_;
-        }
-
         bool HaveNext() const noexcept {
-            return index_ < (from_->end_ - from_->first_);
+            return index_ < SizeType(from_->last_ - from_->first_);
         }
 
         bool HavePrev() const noexcept {
             return index_ != 0;
         }
 
-        List<T>::Iterator Next() const {
-            // assert(List<T>::Iterator::HaveNext());
-            return List<T>::Iterator(pos_ + 1, index_ + 1, from_);
+        List::Iterator Next() const {
+            return List::Iterator(pos_ + 1, index_ + 1, from_);
         }
 
-
-        List<T>::Iterator CheckedNext() const {
-            assert(List<T>::Iterator::HaveNext());
-            return List<T>::Iterator(pos_ + 1, index_ + 1, from_);
+        List::Iterator CheckedNext() const {
+            assert(List::Iterator::HaveNext());
+            return List::Iterator(pos_ + 1, index_ + 1, from_);
         }
 
-        List<T>::Iterator Prev() const {
-            // assert(List<T>::Iterator::HavePrev());
-            return List<T>::Iterator(pos_ - 1, index_ - 1, from_);
+        List::Iterator Prev() const {
+            return List::Iterator(pos_ - 1, index_ - 1, from_);
         }
 
-        List<T>::Iterator CheckedPrev() const {
-            assert(List<T>::Iterator::HavePrev());
-            return List<T>::Iterator(pos_ - 1, index_ - 1, from_);
+        List::Iterator CheckedPrev() const {
+            assert(List::Iterator::HavePrev());
+            return List::Iterator(pos_ - 1, index_ - 1, from_);
         }
 
     private:
-        T *const pos_;
-        const SizeType index_;
-        const List<T> *from_;
+        T *pos_;
+        SizeType index_;
+        const List *from_;
 
-        Iterator(T *pos, SizeType index, const List<T> *from)
+        Iterator(T *pos, SizeType index, const List *from)
                 : pos_(pos), index_(index), from_(from) {}
 
-        friend class List<T>;
+        friend class List;
     };
 
     /**
-     *
+     * The read-only counterpart of Iterator.
      */
-    class ConstIterator {
+    class ConstIterator : public IConstIterator<ConstIterator, T> {
     public:
         ConstIterator() = delete;
 
-        ConstIterator(const List<T>::ConstIterator &other) noexcept
-                : pos_(other.pos_), index_(other.index_), from_(other.from_) {}
-
-        List<T>::ConstIterator &operator=(const List<T>::ConstIterator &other) {
-            if (this == &other) {
-                return *this;
-            }
-            new(this)List<T>::ConstIterator(other.pos_, other.index_, other.from_);
+        const T &Instance() const noexcept {
+            return *pos_;
         }
 
-        bool operator==(const List<T>::ConstIterator &other) const noexcept {
+        bool Equals(const List::ConstIterator &other) const noexcept {
             return from_->data_ == other.from_->data_ && pos_ == other.pos_;
         }
 
-        bool operator!=(const List<T>::ConstIterator &other) const noexcept {
-            return !(from_->data_ == other.from_->data_ && pos_ == other.pos_);
+        bool HaveNext() const noexcept {
+            return index_ < SizeType(from_->last_ - from_->first_);
         }
 
-        const T &Instance() noexcept {
-            return *pos_;
+        bool HavePrev() const noexcept {
+            return index_ != 0;
         }
 
-        bool HaveNext() const noexcept {
-            return index_ < (from_->last_ - from_->first_);
+        List::ConstIterator Next() const {
+            return List::ConstIterator(pos_ + 1, index_ + 1, from_);
         }
 
-        bool HavePrev() const noexcept {
-            return index_ != 0;
+        List::ConstIterator CheckedNext() const {
+            assert(List::ConstIterator::HaveNext());
+            return List::ConstIterator(pos_ + 1, index_ + 1, from_);
         }
 
-        List<T>::ConstIterator Next() const {
-            assert(List<T>::ConstIterator::HaveNext());
-            return List<T>::ConstIterator(pos_ + 1, index_ + 1, from_);
+        List::ConstIterator Prev() const {
+            return List::ConstIterator(pos_ - 1, index_ - 1, from_);
         }
 
-        List<T>::ConstIterator Prev() const {
-            assert(List<T>::ConstIterator::HavePrev());
-            return List<T>::ConstIterator(pos_ - 1, index_ - 1, from_);
+        List::ConstIterator CheckedPrev() const {
+            assert(List::ConstIterator::HavePrev());
+            return List::ConstIterator(pos_ - 1, index_ - 1, from_);
         }
 
     private:
-        const T *const pos_;
-        const SizeType index_;
-        const List<T> *const from_;
+        const T *pos_;
+        SizeType index_;
+        const List *from_;
 
-        ConstIterator(const T *pos, const SizeType index, const List<T> *from)
+        ConstIterator(const T *pos, SizeType index, const List *from)
                 : pos_(pos), index_(index), from_(from) {}
 
-        friend class List<T>;
+        friend class List;
     };
 
+    // The iterators of begin() and end(), see there.
+    using RangeIterator = Internal::RangeIterator<T>;
+    using ConstRangeIterator = Internal::RangeIterator<const T>;
+
     /**
-     * Creates an empty \c List<T> instance
+     * Creates an empty \c List instance
      */
     List() noexcept
             : data_(nullptr), first_(nullptr), last_(nullptr), end_(nullptr) {}
 
 
     /**
-     * Creates an List<T> with the given \p value repeating \p count of times.
+     * Creates an List with the given \p value repeating \p count of times.
      * @param count the count of \p value intended to be plugged in
      * @param value the given \p value
      * @param front_offset the amount of spaces intended to reserve before the first \p value
@@ -160,13 +151,13 @@ public:
     List(SizeType count, const T &value, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (count) {
             SizeType size = front_offset + count + back_offset;
-            for (T *pos = List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr) + front_offset;
+            for (T *pos = List::SimpleAllocate(size, List::Cap(size)) + front_offset;
                  count > 0;
                  --count, ++pos) {
                 TypeTrait::Assign(pos, value);
             }
         } else {
-            new(this)List<T>();
+            new(this)List();
         }
     }
 
@@ -180,9 +171,9 @@ public:
     List(const T *source, SizeType count, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (source && count) {
             SizeType size = front_offset + count + back_offset;
-            TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr) + front_offset, source, count);
+            TypeTrait::Copy(List::SimpleAllocate(size, List::Cap(size)) + front_offset, source, count);
         } else {
-            new(this)List<T>();
+            new(this)List();
         }
     }
 
@@ -190,19 +181,17 @@ public:
      *
      * @param other
      */
-    List(const List<T> &other) noexcept {
+    List(const List &other) noexcept {
         if (&other == this) {
             return;
         } else {
-            if (other.data_) {
-                ::memcpy(this, &other, sizeof(List<T>));
-                if (*data_) {
-                    (**data_).IncrementRef();
-                } else {
-                    *data_ = new RefCount(2);
-                }
+            if (!Thread::kShareable) {
+                new(this)List(other.first_, other.Count());
+            } else if (other.data_) {
+                ::memcpy(this, &other, sizeof(List));
+                data_->IncrementRef();
             } else {
-                new(this)List<T>();
+                new(this)List();
             }
         }
     }
@@ -211,13 +200,10 @@ public:
      *
      * @param other
      */
-    List(List<T> &&other) noexcept {
-        if (&other == this) {
-            return;
-        } else {
-            ::memcpy(this, &other, sizeof(List<T>));
-            ::memset(&other, 0, sizeof(List<T>));
-        }
+    List(List &&other) noexcept
+            : data_(other.data_), first_(other.first_), last_(other.last_), end_(other.end_) {
+        other.data_ = nullptr;
+        other.first_ = other.last_ = other.end_ = nullptr;
     }
 
     /**
@@ -228,15 +214,15 @@ public:
      * @param front_offset
      * @param back_offset
      */
-    List(const List<T> &other, SizeType count, SizeType offset,
+    List(const List &other, SizeType count, SizeType offset,
          SizeType front_offset = 0, SizeType back_offset = 0) {
         if (&other == this) {
             assert(false);
         }
         if (count) {
-            new(this)List<T>(other.first_ + offset, count, front_offset, back_offset);
+            new(this)List(other.first_ + offset, count, front_offset, back_offset);
         } else {
-            new(this)List<T>();
+            new(this)List();
         }
     }
 
@@ -246,12 +232,12 @@ public:
      */
     List(const std::initializer_list<T> i) {
         if (SizeType s = i.size()) {
-            T *pos = List<T>::SimpleAllocate(i.size(), Cap(i.size()), nullptr);
+            T *pos = List::SimpleAllocate(i.size(), Cap(i.size()));
             for (auto it = i.begin(); it != i.end(); ++it, ++pos) {
                 TypeTrait::Assign(pos, *it);
             }
         } else {
-            new(this)List<T>();
+            new(this)List();
         }
     }
 
@@ -264,19 +250,15 @@ public:
      */
     ~List() {
         if (data_) { // check if it needs to do something
-            if (*data_) { // check if it has RC
-                if ((**data_).Value() > 1) { // sharing
-                    (**data_).DecrementRef(); // decrease and quit
-                    return;
-                }
-                delete *data_; // = 1, thus the RC is no longer needed.
+            if (data_->Value() > 1 && !data_->ReleaseRef()) { // sharing, decrease and quit
+                return;
             }
             // We need to free the memory.
             // To avoid memory leak, we need to run the destructor of every existing element.
-            for (T *pos = first_; pos != end_; ++pos) {
+            for (T *pos = first_; pos != last_; ++pos) {
                 TypeTrait::Destroy(pos);
             }
-            ::free(static_cast<void *>(data_)); // NO MEMORY LEAK AT ALL!!!!!!
+            List::SimpleFree(); // NO MEMORY LEAK AT ALL!!!!!!
         }
     }
 
@@ -286,11 +268,11 @@ public:
      */
     T *Data() {
         if (data_) {
-            if ((*data_) && (**data_).Value() > 1) {
+            if (data_->Value() > 1) {
                 T *old = first_;
                 SizeType size = last_ - first_;
-                (**data_).DecrementRef();
-                TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr), old, size);
+                data_->DecrementRef();
+                TypeTrait::Copy(List::SimpleAllocate(size, List::Cap(size)), old, size);
             }
             return first_;
         }
@@ -314,12 +296,10 @@ public:
         assert(data_);
         SizeType size = last_ - first_;
         assert(index < size);
-        if (*data_) {
-            if ((*data_) && (**data_).Value() > 1) {
-                T *old = first_;
-                (**data_).DecrementRef();
-                TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr), old, size);
-            }
+        if (data_->Value() > 1) {
+            T *old = first_;
+            data_->DecrementRef();
+            TypeTrait::Copy(List::SimpleAllocate(size, List::Cap(size)), old, size);
         }
         return *(first_ + index);
     }
@@ -329,18 +309,16 @@ public:
      * @param index
      * @return
      */
-    List<T>::Iterator IteratorAt(SizeType index) {
+    List::Iterator IteratorAt(SizeType index) {
         assert(data_);
         SizeType size = last_ - first_;
         assert(index < size);
-        if (*data_) {
-            if ((*data_) && (**data_).Value() > 1) {
-                T *old = first_;
-                (**data_).DecrementRef();
-                TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr), old, size);
-            }
+        if (data_->Value() > 1) {
+            T *old = first_;
+            data_->DecrementRef();
+            TypeTrait::Copy(List::SimpleAllocate(size, List::Cap(size)), old, size);
         }
-        return List<T>::Iterator(data_ + index, index, this);
+        return List::Iterator(first_ + index, index, this);
     }
 
     /**
@@ -353,21 +331,19 @@ public:
         return *(first_ + index);
     }
 
-    List<T>::ConstIterator ConstIteratorAt(SizeType index) const {
+    List::ConstIterator ConstIteratorAt(SizeType index) const {
         assert(index < last_ - first_);
-        return List<T>::ConstIterator(data_ + index, index, this);
+        return List::ConstIterator(first_ + index, index, this);
     }
 
-    List<T> &SetAt(SizeType index, const T &value) {
+    List &SetAt(SizeType index, const T &value) {
         assert(data_);
         SizeType size = last_ - first_;
         assert(index < size);
-        if (*data_) {
-            if ((*data_) && (**data_).Value() > 1) {
-                T *old = first_;
-                (**data_).DecrementRef();
-                TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr), old, size);
-            }
+        if (data_->Value() > 1) {
+            T *old = first_;
+            data_->DecrementRef();
+            TypeTrait::Copy(List::SimpleAllocate(size, List::Cap(size)), old, size);
         }
         TypeTrait::Assign(first_ + index, value);
         return *this;
@@ -405,133 +381,243 @@ public:
      *
      * @return
      */
-    List<T>::Iterator First() noexcept {
-        if (data_ && (*data_) && (**data_).Value() > 1) {
+    List::Iterator First() noexcept {
+        if (data_ && data_->Value() > 1) {
             T *old = first_;
             SizeType size = last_ - first_;
-            (**data_).DecrementRef();
-            TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr), old, size);
+            data_->DecrementRef();
+            TypeTrait::Copy(List::SimpleAllocate(size, List::Cap(size)), old, size);
         }
-        return List<T>::Iterator(first_, 0, this);
+        return List::Iterator(first_, 0, this);
     }
 
     /**
      *
      * @return
      */
-    List<T>::ConstIterator ConstFirst() const noexcept {
-        return List<T>::ConstIterator(first_, 0, this);
+    List::ConstIterator ConstFirst() const noexcept {
+        return List::ConstIterator(first_, 0, this);
     }
 
     /**
      *
      * @return
      */
-    List<T>::Iterator Last() noexcept {
+    List::Iterator Last() noexcept {
         SizeType size = last_ - first_;
-        if (data_ && (*data_) && (**data_).Value() > 1) {
+        if (data_ && data_->Value() > 1) {
             T *old = first_;
-            (**data_).DecrementRef();
-            TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr), old, size);
+            data_->DecrementRef();
+            TypeTrait::Copy(List::SimpleAllocate(size, List::Cap(size)), old, size);
         }
-        return List<T>::Iterator(last_, size, this);
+        return List::Iterator(last_, size, this);
     }
 
     /**
      *
      * @return
      */
-    List<T>::ConstIterator ConstLast() const noexcept {
-        return List<T>::ConstIterator(last_, List<T>::Count(), this);
+    List::ConstIterator ConstLast() const noexcept {
+        return List::ConstIterator(last_, List::Count(), this);
+    }
+
+    /*
+     * The iterators range-for and the std algorithms look for: plain pointers in release builds,
+     * so that iterating compiles to a pointer loop, and bound-checked pointers in debug builds,
+     * see internal/checked_pointer.h. Unlike Iterator, they do not track the instance, thus
+     * they are invalidated by anything that may reallocate.
+     * The non-const ones detach a shared block, just like First and Last.
+     */
+
+    List::RangeIterator begin() {
+        T *data = List::Data();
+        return Internal::MakeRangeIterator(data, data, last_);
+    }
+
+    List::RangeIterator end() {
+        T *data = List::Data();
+        return Internal::MakeRangeIterator(last_, data, last_);
+    }
+
+    List::ConstRangeIterator begin() const noexcept {
+        return Internal::MakeRangeIterator<const T>(first_, first_, last_);
+    }
+
+    List::ConstRangeIterator end() const noexcept {
+        return Internal::MakeRangeIterator<const T>(last_, first_, last_);
     }
 
     /**
      *
      * @return
      */
-    List<T> &Clear() {
+    List &Clear() {
         if (data_) {
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
-                new(this)List<T>();
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
+                new(this)List();
             } else {
-                for (; last_ != first_; --last_) {
-                    TypeTrait::Destroy(last_);
+                for (; last_ != first_;) {
+                    TypeTrait::Destroy(--last_);
                 }
+                first_ = last_ = List::Origin(); // give the headroom back to the back.
             }
         }
         return *this;
     }
 
     /**
-     *
+     * Equivalent to <tt>Reserve(capacity, true)</tt>.
      * @param capacity
      * @return
      */
-    List<T> &EnsureCapacity(SizeType capacity) {
+    List &EnsureCapacity(SizeType capacity) {
+        return List::Reserve(capacity, true);
+    }
+
+    /**
+     * Makes room for at least \p capacity elements, so that appending up to that amount does not reallocate.
+     * Nothing happens if the capacity is already large enough and the block is not shared.
+     * @param capacity the intended capacity
+     * @param exact true to allocate exactly \p capacity slots, false to let \c Growth add its slack
+     * @return the reference of this instance
+     */
+    List &Reserve(SizeType capacity, bool exact = false) {
+        SizeType size = List::Count();
+        if (capacity < size) {
+            capacity = size;
+        }
+        if (!capacity) {
+            return *this;
+        }
+        SizeType new_capacity = exact ? capacity : List::Cap(capacity);
         if (data_) {
-            if (capacity > end_ - first_) {
-                SizeType size = last_ - first_;
-                if (*data_ && (**data_).Value() > 1) {
-                    T *old = first_;
-                    (**data_).DecrementRef();
-                    TypeTrait::Copy(List<T>::SimpleAllocate(size, List<T>::Cap(size), nullptr), old, size);
-                } else {
-                    List<T>::SimpleReallocate(size, capacity);
-                }
+            if (data_->Value() > 1) {
+                T *old = first_;
+                data_->DecrementRef();
+                TypeTrait::Copy(List::SimpleAllocate(size, new_capacity), old, size);
+            } else if (capacity > SizeType(end_ - first_)) {
+                List::SimpleReallocate(size, new_capacity);
             }
         } else {
-            List<T>::SimpleAllocate(0, capacity, nullptr);
+            List::SimpleAllocate(0, new_capacity);
         }
         return *this;
     }
 
     /**
-     *
-     * @param other
-     * @param Equals
-     * @return
+     * Gives the unused capacity back to \c Allocator, including the headroom before the first element.
+     * An empty instance releases its block entirely.
+     * A shared block is left alone, since detaching would only add another block.
+     * @return the reference of this instance
      */
-    bool Equals(const List<T> &other, bool(*Equals)(const T &, const T &)) {
-        if (&other == this) {
-            return true;
-        } else if (other.Count() != Count()) {
-            return false;
-        } else {
-            for (T *left_pos = first_, *right_pos = other.first_;
-                 left_pos != last_;
-                 ++left_pos, ++right_pos) {
-                if (!Equals(*left_pos, *right_pos)) {
-                    return false;
-                }
+    List &ShrinkToFit() {
+        if (!data_ || (data_->Value() > 1)) {
+            return *this;
+        }
+        SizeType size = last_ - first_;
+        if (!size) {
+            List::SimpleFree();
+            new(this)List();
+        } else if (first_ != List::Origin() || last_ != end_) {
+            if (first_ != List::Origin()) {
+                TypeTrait::Move(List::Origin(), first_, size);
+                first_ = List::Origin();
+                last_ = first_ + size;
             }
-            return true;
+            List::SimpleReallocate(size, size);
         }
+        return *this;
     }
 
     /**
-     *
-     * @param other
-     * @param Compare
-     * @return
+     * Checks if both instances hold equal elements in the same order.
+     * Pod integral elements with the default \p equal are compared block by block with memcmp.
+     * @param other another instance
+     * @param equal a callable returning true if both arguments are equal
+     * @return true if both instances are equal
      */
-    bool CompareTo(const List<T> &other, int(Compare)(const T &, const T &)) {
-        if (&other == this) {
+    template<typename Equal = Internal::EqualTo<T>>
+    bool Equals(const List &other, Equal equal = Equal()) const {
+        if (&other == this || (other.first_ == first_ && other.last_ == last_)) {
             return true;
         } else if (other.Count() != Count()) {
             return false;
         } else {
-            int rtn;
-            for (T *left_pos = first_, *right_pos = other.first_;
-                 left_pos != last_;
-                 ++left_pos, ++right_pos) {
-                rtn = Compare(*left_pos, *right_pos);
-                if (rtn) {
-                    return rtn;
-                }
-            }
+            return Internal::RangeEquals(first_, other.first_, List::Count(), equal);
+        }
+    }
+
+    /**
+     * Compares both instances lexicographically.
+     * Pod integral elements with the default \p compare skip equal blocks with memcmp.
+     * @param other another instance
+     * @param compare a callable returning negative, zero or positive
+     * @return negative if the current instance goes first, zero if both are equal, positive otherwise
+     */
+    template<typename Compare = Internal::ThreeWayCompare<T>>
+    int CompareTo(const List &other, Compare compare = Compare()) const {
+        if (&other == this || (other.first_ == first_ && other.last_ == last_)) {
             return 0;
         }
+        return Internal::RangeCompareTo(first_, List::Count(), other.first_, other.Count(), compare);
+    }
+
+    /**
+     * Hashes the elements, so that equal instances have equal hashes.
+     * Integral, enum and pointer elements are hashed block by block as bytes,
+     * other elements by their Hash() member if they have one, or by std::hash.
+     * @return the hash, which is not stable across processes
+     */
+    SizeType Hash() const {
+        return SizeType(Internal::RangeHash(first_, List::Count()));
+    }
+
+    /**
+     * Finds the first element equal to \p value.
+     * Arithmetic Pod elements are scanned by SSE2/AVX2 kernels, see internal/simd.h.
+     * @param value the element to look for
+     * @param from the index where the search starts
+     * @return the index of the element, or -1 if not found
+     */
+    SizeType IndexOf(const T &value, SizeType from = 0) const {
+        SizeType size = List::Count();
+        if (from >= size) {
+            return SizeType(-1);
+        }
+        const T *pos = Internal::ElementSearch<T, TypeTrait>::Find(first_ + from, last_, value);
+        return pos ? SizeType(pos - first_) : SizeType(-1);
+    }
+
+    /**
+     * Finds the last element equal to \p value.
+     * @param value the element to look for
+     * @param before the search covers only the elements before this index
+     * @return the index of the element, or -1 if not found
+     */
+    SizeType LastIndexOf(const T &value, SizeType before = SizeType(-1)) const {
+        SizeType size = List::Count();
+        if (before > size) {
+            before = size;
+        }
+        const T *pos = Internal::ElementSearch<T, TypeTrait>::ReverseFind(first_, first_ + before, value);
+        return pos ? SizeType(pos - first_) : SizeType(-1);
+    }
+
+    /**
+     * @param value the element to look for
+     * @return true if any element is equal to \p value
+     */
+    bool Contains(const T &value) const {
+        return List::IndexOf(value) != SizeType(-1);
+    }
+
+    /**
+     * @param value the element to count
+     * @return the amount of elements equal to \p value
+     */
+    SizeType CountOf(const T &value) const {
+        return Internal::ElementSearch<T, TypeTrait>::Count(first_, last_, value);
     }
 
     /**
@@ -542,9 +628,9 @@ public:
      * @param back_offset
      * @return
      */
-    List<T> &Reassign(const T &value, SizeType count = 1,
+    List &Reassign(const T &value, SizeType count = 1,
                       SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::AssignImpl(front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::AssignImpl(front_offset + count + back_offset) + front_offset) {
             for (; count > 0; --count, ++pos) {
                 TypeTrait::Assign(pos, value);
             }
@@ -560,32 +646,32 @@ public:
      * @param back_offset
      * @return
      */
-    List<T> &Reassign(const T *data, SizeType count,
+    List &Reassign(const T *data, SizeType count,
                       SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::AssignImpl(front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::AssignImpl(front_offset + count + back_offset) + front_offset) {
             TypeTrait::Copy(pos, data, count);
         }
         return *this;
     }
 
-    List<T> &Reassign(const List<T> &other, SizeType count = 1,
+    List &Reassign(const List &other, SizeType count = 1,
                       SizeType front_offset = 0, SizeType back_offset = 0) {
         if (data_) {
-            return List<T>::Append(other.data_, other.size_, front_offset, back_offset);
+            return List::Append(other.data_, other.size_, front_offset, back_offset);
         }
     }
 
-    List<T> &Reassign(const List<T> &other, SizeType from, SizeType to,
+    List &Reassign(const List &other, SizeType from, SizeType to,
                       SizeType front_offset = 0, SizeType back_offset = 0) {
         if (other.data_ && other.size_ && from < to && to < other.size_) {
-            return List<T>::Append(other.data_ + from, to, front_offset, front_offset);
+            return List::Append(other.data_ + from, to, front_offset, front_offset);
         }
         return *this;
     }
 
-    List<T> &Append(const T &value, SizeType count = 1,
+    List &Append(const T &value, SizeType count = 1,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::GrowthAppend(front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::GrowthAppend(front_offset + count + back_offset) + front_offset) {
             for (; count > 0; --count, ++pos) {
                 TypeTrait::Assign(pos, value);
             }
@@ -593,32 +679,42 @@ public:
         return *this;
     }
 
-    List<T> &Append(const T *data, SizeType count,
+    /**
+     * Moves \p value to the end of the instance.
+     * @param value the element intended to be moved in
+     * @return the reference to the current instance
+     */
+    List &Append(T &&value) {
+        TypeTrait::Assign(List::GrowthAppend(1), std::move(value));
+        return *this;
+    }
+
+    List &Append(const T *data, SizeType count,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::GrowthAppend(front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::GrowthAppend(front_offset + count + back_offset) + front_offset) {
             TypeTrait::Copy(pos, data, count);
         }
         return *this;
     }
 
-    List<T> &Append(const List<T> &other, SizeType count = 1,
+    List &Append(const List &other, SizeType count = 1,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
         if (data_) {
-            return List<T>::Append(other.data_, other.size_, front_offset, back_offset);
+            return List::Append(other.data_, other.size_, front_offset, back_offset);
         }
     }
 
-    List<T> &Append(const List<T> &other, SizeType from, SizeType to,
+    List &Append(const List &other, SizeType from, SizeType to,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
         if (other.data_ && other.size_ && from < to && to < other.size_) {
-            return List<T>::Append(other.data_ + from, to, front_offset, front_offset);
+            return List::Append(other.data_ + from, to, front_offset, front_offset);
         }
         return *this;
     }
 
-    List<T> &Prepend(const T &value, SizeType count = 1,
+    List &Prepend(const T &value, SizeType count = 1,
                      SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::GrowthPrepend(front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::GrowthPrepend(front_offset + count + back_offset) + front_offset) {
             for (; count > 0; --count, ++pos) {
                 TypeTrait::Assign(pos, value);
             }
@@ -626,32 +722,42 @@ public:
         return *this;
     }
 
-    List<T> &Prepend(const T *data, SizeType count,
+    /**
+     * Moves \p value to the front of the instance.
+     * @param value the element intended to be moved in
+     * @return the reference to the current instance
+     */
+    List &Prepend(T &&value) {
+        TypeTrait::Assign(List::GrowthPrepend(1), std::move(value));
+        return *this;
+    }
+
+    List &Prepend(const T *data, SizeType count,
                      SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::GrowthPrepend(front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::GrowthPrepend(front_offset + count + back_offset) + front_offset) {
             TypeTrait::Copy(pos, data, count);
         }
         return *this;
     }
 
-    List<T> &Prepend(const List<T> &other, SizeType count = 1,
+    List &Prepend(const List &other, SizeType count = 1,
                      SizeType front_offset = 0, SizeType back_offset = 0) {
         if (data_) {
-            return List<T>::Prepend(other.data_, other.size_, front_offset, back_offset);
+            return List::Prepend(other.data_, other.size_, front_offset, back_offset);
         }
     }
 
-    List<T> &Prepend(const List<T> &other, SizeType from, SizeType to,
+    List &Prepend(const List &other, SizeType from, SizeType to,
                      SizeType front_offset = 0, SizeType back_offset = 0) {
         if (other.data_ && other.size_ && from < to && to < other.size_) {
-            return List<T>::Prepend(other.data_ + from, to, front_offset, front_offset);
+            return List::Prepend(other.data_ + from, to, front_offset, front_offset);
         }
         return *this;
     }
 
-    List<T> &Insert(SizeType index, const T &value, SizeType count = 1,
+    List &Insert(SizeType index, const T &value, SizeType count = 1,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::GrowthInsert(index, front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::GrowthInsert(index, front_offset + count + back_offset) + front_offset) {
             for (; count > 0; --count, ++pos) {
                 TypeTrait::Assign(pos, value);
             }
@@ -659,64 +765,327 @@ public:
         return *this;
     }
 
-    List<T> &Insert(SizeType index, const T *data, SizeType count,
+    /**
+     * Moves \p value to the position \p index of the instance.
+     * @param index the position, no larger than Count()
+     * @param value the element intended to be moved in
+     * @return the reference to the current instance
+     */
+    List &Insert(SizeType index, T &&value) {
+        TypeTrait::Assign(List::GrowthInsert(index, 1), std::move(value));
+        return *this;
+    }
+
+    List &Insert(SizeType index, const T *data, SizeType count,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
-        if (T *pos = List<T>::GrowthInsert(index, front_offset + count + back_offset) + front_offset) {
+        if (T *pos = List::GrowthInsert(index, front_offset + count + back_offset) + front_offset) {
             TypeTrait::Copy(pos, data, count);
         }
         return *this;
     }
 
-    List<T> &Insert(SizeType index, const List<T> &other, SizeType count = 1,
+    List &Insert(SizeType index, const List &other, SizeType count = 1,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
         if (data_) {
-            return List<T>::Insert(index, other.data_, other.size_, front_offset, back_offset);
+            return List::Insert(index, other.data_, other.size_, front_offset, back_offset);
         }
     }
 
-    List<T> &Insert(SizeType index, const List<T> &other, SizeType from, SizeType to,
+    List &Insert(SizeType index, const List &other, SizeType from, SizeType to,
                     SizeType front_offset = 0, SizeType back_offset = 0) {
         if (other.data_ && other.size_ && from < to && to < other.size_) {
-            return List<T>::Insert(index, other.data_ + from, to, front_offset, front_offset);
+            return List::Insert(index, other.data_ + from, to, front_offset, front_offset);
         }
         return *this;
     }
 
+    /**
+     * Constructs an element at the end of the instance in place,
+     * forwarding \p args to the constructor of \c T.
+     * @param args the arguments of the constructor
+     * @return the reference to the current instance
+     */
+    template<typename... Args>
+    List &Emplace(Args &&... args) {
+        new(List::GrowthAppend(1))T(std::forward<Args>(args)...);
+        return *this;
+    }
+
+    /**
+     * Constructs an element at the position \p index in place,
+     * forwarding \p args to the constructor of \c T.
+     * @param index the position, no larger than Count()
+     * @param args the arguments of the constructor
+     * @return the reference to the current instance
+     */
+    template<typename... Args>
+    List &EmplaceAt(SizeType index, Args &&... args) {
+        new(List::GrowthInsert(index, 1))T(std::forward<Args>(args)...);
+        return *this;
+    }
+
+    /**
+     * Constructs an element at the front of the instance in place,
+     * forwarding \p args to the constructor of \c T.
+     * @param args the arguments of the constructor
+     * @return the reference to the current instance
+     */
+    template<typename... Args>
+    List &EmplaceFront(Args &&... args) {
+        new(List::GrowthPrepend(1))T(std::forward<Args>(args)...);
+        return *this;
+    }
+
     /**
      * Removes the existing elements starting from \p index and continuing \p count times.
+     * The shorter side of the remaining elements is shifted, thus removing from the front
+     * only advances \c first_ and leaves the space as headroom for later prepends.
      * @param index the first element intended to be removed
      * @param count the amount of elements intended to be removed
      * @return the reference to the current instance
      */
-    List<T> &Remove(SizeType index, SizeType count = 1) {
-        if (data_) {
+    List &Remove(SizeType index, SizeType count = 1) {
+        if (data_ && count) {
             SizeType old_size = last_ - first_;
-            assert(index + count < old_size);
-            SizeType new_size = old_size - count;
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
+            assert(index + count <= old_size);
+            SizeType new_size = old_size - count, tail = old_size - index - count;
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
                 T *old = first_;
                 TypeTrait::Copy(
-                        List<T>::SimpleAllocate(new_size, Cap(new_size), nullptr),
+                        List::SimpleAllocate(new_size, Cap(new_size)),
                         old,
                         index
                 );
-                TypeTrait::Copy(first_ + index, old + index + count, old_size - index);
+                TypeTrait::Copy(first_ + index, old + index + count, tail);
             } else {
                 SizeType remain = count;
                 for (T *pos = first_ + index; remain > 0; --remain, ++pos) {
                     TypeTrait::Destroy(pos);
                 }
-                TypeTrait::Move(first_ + index, first_ + index + count, old_size - index - count);
-                last_ -= count;
+                if (index < tail) {
+                    TypeTrait::Move(first_ + count, first_, index);
+                    first_ += count;
+                } else {
+                    TypeTrait::Move(first_ + index, first_ + index + count, tail);
+                    last_ -= count;
+                }
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * Removes every element satisfying \p predicate in a single pass.
+     * The survivors keep their order. A shared instance detaches once, copying only the survivors.
+     * @param predicate a callable taking <tt>const T &</tt>, returning true if the element should be removed
+     * @return the reference to the current instance
+     */
+    template<typename Predicate>
+    List &RemoveIf(Predicate predicate) {
+        if (data_) {
+            if (data_->Value() > 1) {
+                T *old = first_, *old_last = last_;
+                SizeType old_size = last_ - first_;
+                data_->DecrementRef();
+                T *pos = List::SimpleAllocate(0, List::Cap(old_size));
+                for (; old != old_last; ++old) {
+                    if (!predicate(*old)) {
+                        TypeTrait::Assign(pos++, *old);
+                    }
+                }
+                last_ = pos;
+            } else {
+                T *pos = first_;
+                for (T *curr = first_; curr != last_; ++curr) {
+                    if (predicate(*curr)) {
+                        TypeTrait::Destroy(curr);
+                    } else {
+                        if (pos != curr) {
+                            TypeTrait::Move(pos, curr, 1);
+                        }
+                        ++pos;
+                    }
+                }
+                last_ = pos;
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * Removes the elements at every position in \p indices in a single pass.
+     * @param indices valid positions, sorted in ascending order without duplicates
+     * @return the reference to the current instance
+     */
+    template<typename IndexAllocator, typename IndexGrowth, typename IndexThread>
+    List &RemoveAll(const List<SizeType, IndexAllocator, IndexGrowth, IndexThread> &indices) {
+        SizeType remove_count = indices.Count();
+        if (data_ && remove_count) {
+            const SizeType *index = indices.ConstData(), *index_end = index + remove_count;
+            SizeType old_size = last_ - first_;
+            assert(index[remove_count - 1] < old_size);
+            if (data_->Value() > 1) {
+                T *old = first_;
+                data_->DecrementRef();
+                T *pos = List::SimpleAllocate(old_size - remove_count, List::Cap(old_size - remove_count));
+                for (SizeType i = 0; i < old_size; ++i) {
+                    if (index != index_end && *index == i) {
+                        ++index;
+                    } else {
+                        TypeTrait::Assign(pos++, old[i]);
+                    }
+                }
+            } else {
+                T *pos = first_ + *index;
+                for (; index != index_end; ++index) {
+                    assert(index + 1 == index_end || index[0] < index[1]);
+                    TypeTrait::Destroy(first_ + *index);
+                    // the survivors between this index and the next one move down as a block.
+                    SizeType next = (index + 1 == index_end) ? old_size : index[1];
+                    SizeType keep = next - *index - 1;
+                    TypeTrait::Move(pos, first_ + *index + 1, keep);
+                    pos += keep;
+                }
+                last_ = pos;
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * Inserts \p values[i] before the element originally at \p indices[i], for every i, in a single pass.
+     * An index equal to Count() appends.
+     * @param indices positions in the original instance, sorted in non-descending order
+     * @param values the elements intended to be inserted, as many as \p indices
+     * @return the reference to the current instance
+     */
+    template<typename IndexAllocator, typename IndexGrowth, typename IndexThread>
+    List &InsertMany(const List<SizeType, IndexAllocator, IndexGrowth, IndexThread> &indices, const T *values) {
+        SizeType insert_count = indices.Count();
+        if (!insert_count) {
+            return *this;
+        }
+        const SizeType *index = indices.ConstData();
+        SizeType old_size = List::Count(), new_size = old_size + insert_count;
+        assert(index[insert_count - 1] <= old_size);
+        bool shared = data_ && data_->Value() > 1;
+        if (shared || (data_ && !TypeTrait::kRelocatable && new_size > SizeType(end_ - first_))) {
+            // A shared block is copied, a full block of elements which cannot be reallocated bitwise
+            // is replaced. Either way every element goes straight to its final slot in a new block.
+            RefCount *old_data = data_;
+            SizeType old_total = end_ - List::Origin();
+            T *old = first_;
+            if (shared) {
+                data_->DecrementRef();
+            }
+            T *pos = List::SimpleAllocate(new_size, List::Cap(new_size));
+            SizeType done = 0;
+            for (SizeType i = 0; i <= insert_count; ++i) {
+                SizeType segment = (i < insert_count ? index[i] : old_size) - done;
+                if (shared) {
+                    TypeTrait::Copy(pos, old + done, segment);
+                } else {
+                    TypeTrait::Move(pos, old + done, segment);
+                }
+                pos += segment, done += segment;
+                if (i < insert_count) {
+                    TypeTrait::Assign(pos++, values[i]);
+                }
+            }
+            if (!shared) {
+                Allocator::Free(old_data, TotCap(old_total));
+            }
+        } else {
+            if (!data_) {
+                List::SimpleAllocate(0, List::Cap(new_size));
+            } else if (new_size > SizeType(end_ - first_)) {
+                List::SimpleReallocate(old_size, List::Cap(new_size)); // bitwise, nothing is moved.
             }
+            // Walk from the back, so that every element moves exactly once.
+            SizeType src_end = old_size, dest_end = new_size;
+            for (SizeType i = insert_count; i > 0; --i) {
+                SizeType segment = src_end - index[i - 1];
+                dest_end -= segment;
+                TypeTrait::Move(first_ + dest_end, first_ + index[i - 1], segment);
+                src_end = index[i - 1];
+                TypeTrait::Assign(first_ + --dest_end, values[i - 1]);
+            }
+            last_ = first_ + new_size;
         }
         return *this;
     }
 
+    template<typename IndexAllocator, typename IndexGrowth, typename IndexThread>
+    List &InsertMany(const List<SizeType, IndexAllocator, IndexGrowth, IndexThread> &indices, const List &values) {
+        assert(indices.Count() == values.Count());
+        return List::InsertMany(indices, values.ConstData());
+    }
+
+    /**
+     * Sorts the elements in ascending order by \p compare, the order of equal elements is unspecified.
+     * Arithmetic Pod elements with the default comparator are sorted by radix,
+     * large ranges are split across threads.
+     * @param compare a functor returning true if the first argument goes before the second one
+     * @return the reference to the current instance
+     */
+    template<typename Compare = Internal::LessThan<T>>
+    List &Sort(Compare compare = Compare()) {
+        if (SizeType size = List::Count()) {
+            T *data = List::Data();
+            Internal::Sorter<T, TypeTrait, Compare>::Sort(data, data + size, compare);
+        }
+        return *this;
+    }
+
+    /**
+     * Sorts the elements in ascending order by \p compare, keeping the order of equal elements.
+     * @param compare a functor returning true if the first argument goes before the second one
+     * @return the reference to the current instance
+     */
+    template<typename Compare = Internal::LessThan<T>>
+    List &StableSort(Compare compare = Compare()) {
+        if (SizeType size = List::Count()) {
+            T *data = List::Data();
+            Internal::Sorter<T, TypeTrait, Compare>::StableSort(data, data + size, compare);
+        }
+        return *this;
+    }
+
+    /**
+     * Places the smallest \p count elements in order at the front, the order of the rest is unspecified.
+     * @param count the amount of elements intended to be sorted
+     * @param compare a functor returning true if the first argument goes before the second one
+     * @return the reference to the current instance
+     */
+    template<typename Compare = Internal::LessThan<T>>
+    List &PartialSort(SizeType count, Compare compare = Compare()) {
+        if (SizeType size = List::Count()) {
+            T *data = List::Data();
+            Internal::PartialSort<T, TypeTrait>(data, data + (count < size ? count : size), data + size, compare);
+        }
+        return *this;
+    }
+
+    /**
+     * Rearranges the elements so that the element at \p index is the one that would be there if sorted,
+     * no element before it goes after it, and no element after it goes before it.
+     * @param index a valid position
+     * @param compare a functor returning true if the first argument goes before the second one
+     * @return the reference to the current instance
+     */
+    template<typename Compare = Internal::LessThan<T>>
+    List &NthElement(SizeType index, Compare compare = Compare()) {
+        SizeType size = List::Count();
+        assert(index < size);
+        T *data = List::Data();
+        Internal::NthElement<T, TypeTrait>(data, data + index, data + size, compare);
+        return *this;
+    }
+
 public:
     using TypeTrait = typename Internal::TypeTraitPatternSelector<T>::Type;
-    using RefCount = typename Internal::ReferenceCount;
+    using RefCount = typename Thread::RefCount;
 
     /**
      * Traditionally, the array-like list stores a collection of elements in
@@ -735,55 +1104,66 @@ public:
 
 
     /**
-     * Calculates the capacity based on the given \p size.
-     * It usually has three cases.
-     *  - 1. the given \p size is 0.
-     *  - 2. the given size is smaller than \p kMinCap.
-     *  - 3. the given size is larger than \p kMinCap
+     * Calculates the capacity based on the given \p size, as decided by \c Growth.
      * @param size
      * @return
      */
     static constexpr SizeType Cap(SizeType size) {
-        if (size) {
-            if (kMinCap && kMinCap * 0.75 >= size) {
-                return kMinCap;
-            }
-            return size * 1.5;
-        }
-        return 0;
+        return Growth::Cap(size, kMinCap);
     }
 
+    /**
+     * The size of the block header holding the reference count, padded so that the elements stay aligned.
+     */
+    static constexpr SizeType kHeader = (sizeof(RefCount) + alignof(T) - 1) / alignof(T) * alignof(T);
+
     /**
      * Calculates the total amount of bytes using in the instance.
-     * The instances contains sizeof(RefCount*) + \p capacity * sizeof(T)
+     * The instances contains kHeader + \p capacity * sizeof(T)
      * @param capacity the given capacity
      * @return the total amount of bytes using in the instance.
      */
     static constexpr SizeType TotCap(SizeType capacity) {
-        return sizeof(RefCount *) + capacity * sizeof(T);
+        return kHeader + capacity * sizeof(T);
     }
 
-    inline List(RefCount **&data, const T *&first, const T *&last, const T *&end)
+    inline List(RefCount *&data, const T *&first, const T *&last, const T *&end)
             : data_(data), first_(first), last_(last), end_(end) {}
 
-    inline List(RefCount **data, const SizeType &size, const SizeType &capacity)
-            : data_(data), first_((T *) (data + 1)), last_(first_ + size), end_(first_ + capacity) {}
+    /**
+     * The memory block is laid out as
+     * [ RefCount | headroom | first_ ... last_ | ... end_ ],
+     * the count lives in the block itself, thus sharing never allocates.
+     * The headroom lets prepending and removing from the front run in amortized constant time.
+     * @return the address of the first slot in the block, where the headroom starts.
+     */
+    T *Origin() const noexcept {
+        return reinterpret_cast<T *>(reinterpret_cast<unsigned char *>(data_) + kHeader);
+    }
 
     /**
-     * Allocates memory for the instance and assigns member variables.
+     * Allocates memory for the instance and assigns member variables, the new block is owned by this instance only.
      * Simple means it does not consider the validity of given value, and existing data.
+     * @param front the amount of headroom reserved before \c first_
      * @return \c first_
      */
-    T *SimpleAllocate(const SizeType &size, const SizeType &capacity, RefCount *const &rc);
+    T *SimpleAllocate(const SizeType &size, const SizeType &capacity, const SizeType &front = 0);
 
     /**
-     *
-     * @param size
-     * @param capacity
-     * @return
+     * Resizes the memory block so that \p capacity slots are available from \c first_,
+     * keeping the current headroom.
+     * @param size the size after reallocation
+     * @param capacity the capacity counting from \c first_
+     * @return \c first_
      */
     T *SimpleReallocate(const SizeType &size, const SizeType &capacity);
 
+    /**
+     * Returns the memory block to \c Allocator.
+     * Simple means it neither touches the reference count nor destroys elements.
+     */
+    void SimpleFree();
+
     /**
      *
      * @param count
@@ -802,7 +1182,7 @@ public:
 
     /**
      * Reserves \p count of space in the given \p index.
-     * The \p index must be valid.
+     * The \p index must be no larger than Count(), the ends are handed to GrowthAppend and GrowthPrepend.
      * @param index
      * @param count
      * @return the address can be inserted elements, or nullptr of failed.
@@ -816,145 +1196,175 @@ public:
      */
     T *AssignImpl(SizeType count);
 
-    RefCount **data_; // The first bytes of the memory associated to this instance.
+    RefCount *data_; // The first bytes of the memory associated to this instance, holding the reference count.
     T *first_; // The address of the first element.
     T *last_; // The address of the last element.
     T *end_; // The address of the end of the memory.
 };
 
-template<typename T>
-T *List<T>::SimpleAllocate(const SizeType &size, const SizeType &capacity, List::RefCount *const &rc) {
-    data_ = static_cast<RefCount **>(::malloc(TotCap(capacity)));
-    assert(data_);
-    *data_ = rc;
-    first_ = (T *) (data_ + 1);
+template<typename T, typename Allocator, typename Growth, typename Thread>
+T *List<T, Allocator, Growth, Thread>::SimpleAllocate(const SizeType &size, const SizeType &capacity,
+                                                      const SizeType &front) {
+    void *block = Allocator::Allocate(TotCap(front + capacity));
+    assert(block);
+    data_ = new(block)RefCount(1);
+    first_ = List::Origin() + front;
     last_ = first_ + size;
     end_ = first_ + capacity;
     return first_;
 }
 
-template<typename T>
-T *List<T>::SimpleReallocate(const SizeType &size, const SizeType &capacity) {
-    SizeType i = sizeof(RefCount *) + capacity * sizeof(T);
-    RefCount **old = data_;
-    RefCount *old_rc = *data_;
-    data_ = reinterpret_cast<RefCount **>(::realloc(data_, TotCap(capacity)));
-    assert(data_);
+template<typename T, typename Allocator, typename Growth, typename Thread>
+T *List<T, Allocator, Growth, Thread>::SimpleReallocate(const SizeType &size, const SizeType &capacity) {
+    // Only an unshared block is reallocated, thus the count moves along with it as 1.
+    RefCount *old = data_;
+    SizeType front = first_ - List::Origin(), old_total = end_ - List::Origin();
+    if (TypeTrait::kRelocatable) {
+        data_ = static_cast<RefCount *>(Allocator::Reallocate(data_, TotCap(old_total), TotCap(front + capacity)));
+        assert(data_);
+    } else { // the elements must be told they are moving, thus realloc is not an option.
+        void *block = Allocator::Allocate(TotCap(front + capacity));
+        assert(block);
+        data_ = new(block)RefCount(1);
+        TypeTrait::Move(List::Origin() + front, first_, last_ - first_);
+        Allocator::Free(old, TotCap(old_total));
+    }
     if (old != data_) {
-        *data_ = old_rc;
-        first_ = (T *) (data_ + 1);
-        last_ = first_ + size;
+        first_ = List::Origin() + front;
     }
+    last_ = first_ + size;
     end_ = first_ + capacity;
     return first_;
 }
 
-template<typename T>
-T *List<T>::GrowthAppend(SizeType count) {
+template<typename T, typename Allocator, typename Growth, typename Thread>
+void List<T, Allocator, Growth, Thread>::SimpleFree() {
+    Allocator::Free(data_, TotCap(end_ - List::Origin()));
+}
+
+template<typename T, typename Allocator, typename Growth, typename Thread>
+T *List<T, Allocator, Growth, Thread>::GrowthAppend(SizeType count) {
     if (count) { // check if insertion can occur.
         if (data_) {
             SizeType old_size = last_ - first_, new_size = old_size + count;
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
                 T *old = first_;
                 TypeTrait::Copy(
-                        List<T>::SimpleAllocate(new_size, List<T>::Cap(new_size), nullptr),
+                        List::SimpleAllocate(new_size, List::Cap(new_size)),
                         old,
                         old_size
                 );
             } else {
-                SizeType old_capacity = end_ - first_;
-                if (new_size > old_capacity) {
-                    List<T>::SimpleReallocate(new_size, Cap(new_size));
-                } else {
+                SizeType old_capacity = end_ - first_, front = first_ - List::Origin();
+                if (new_size <= old_capacity) {
                     last_ += count;
+                } else if (front >= count && front >= old_size) {
+                    // More than half of the used block is headroom left by removals from the front,
+                    // slide the elements back to the origin instead of growing.
+                    TypeTrait::Move(List::Origin(), first_, old_size);
+                    first_ = List::Origin();
+                    last_ = first_ + new_size;
+                } else {
+                    List::SimpleReallocate(new_size, Cap(new_size));
                 }
             }
             return first_ + old_size;
         } else {
-            return List<T>::SimpleAllocate(count, Cap(count), nullptr);
+            return List::SimpleAllocate(count, Cap(count));
         }
     }
     return nullptr;
 }
 
-template<typename T>
-T *List<T>::GrowthPrepend(SizeType count) {
+template<typename T, typename Allocator, typename Growth, typename Thread>
+T *List<T, Allocator, Growth, Thread>::GrowthPrepend(SizeType count) {
     if (count) {
         if (data_) {
             SizeType old_size = last_ - first_, new_size = old_size + count;
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
+            // the headroom grows geometrically, just like the capacity at the back.
+            SizeType back = end_ - last_, front = List::Cap(new_size) - new_size;
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
                 T *old = first_;
                 TypeTrait::Copy(
-                        List<T>::SimpleAllocate(new_size, List<T>::Cap(new_size), nullptr) + count,
+                        List::SimpleAllocate(new_size, new_size + back, front) + count,
                         old,
                         old_size
                 );
             } else {
-                SizeType old_capacity = end_ - first_;
-                if (new_size > old_capacity) {
-                    SizeType new_capacity = List<T>::Cap(new_size);
-                    if (new_capacity - old_capacity > old_capacity * 2) {
-                        T *old = first_;
-                        TypeTrait::Copy(
-                                List<T>::SimpleAllocate(new_size, new_capacity, *data_) + count,
-                                old,
-                                old_size
-                        );
-                    } else {
-                        T *pos = List<T>::SimpleReallocate(new_size, new_capacity) + count;
-                        TypeTrait::Move(
-                                pos + count,
-                                first_,
-                                old_size
-                        );
-                    }
+                SizeType old_front = first_ - List::Origin(), total = end_ - List::Origin();
+                if (count <= old_front) { // the common case, just consume the headroom.
+                    first_ -= count;
+                } else if (total >= new_size * 2) {
+                    // The block is large enough but the room is at the back, re-center the elements.
+                    T *pos = List::Origin() + (total - new_size) / 2;
+                    TypeTrait::Move(pos + count, first_, old_size);
+                    first_ = pos;
+                    last_ = first_ + new_size;
                 } else {
-                    TypeTrait::Move(first_ + count, first_, old_size);
-                    last_ += count;
+                    RefCount *old_data = data_;
+                    T *old = first_;
+                    TypeTrait::Move(
+                            List::SimpleAllocate(new_size, new_size + back, front) + count,
+                            old,
+                            old_size
+                    );
+                    Allocator::Free(old_data, TotCap(total));
                 }
             }
             return first_;
         } else {
-            return List<T>::SimpleAllocate(count, Cap(count), nullptr);
+            return List::SimpleAllocate(count, Cap(count));
         }
     }
     return nullptr;
 }
 
-template<typename T>
-T *List<T>::GrowthInsert(SizeType index, SizeType count) {
-    if (count && data_) { // check if insertion can occur.
-        SizeType old_size = last_ - first_; // count the size for verifying and future.
-        assert(index < old_size);
+template<typename T, typename Allocator, typename Growth, typename Thread>
+T *List<T, Allocator, Growth, Thread>::GrowthInsert(SizeType index, SizeType count) {
+    SizeType old_size = last_ - first_; // count the size for verifying and future.
+    assert(index <= old_size);
+    if (index == old_size) { // also covers an empty instance, which has no block yet.
+        return List::GrowthAppend(count);
+    } else if (!index) {
+        return List::GrowthPrepend(count);
+    }
+    if (count) { // check if insertion can occur.
         SizeType new_size = old_size + count;
-        if (*data_ && (**data_).Value() > 1) {
-            (**data_).DecrementRef();
+        if (data_->Value() > 1) {
+            data_->DecrementRef();
             T *old = first_;
             TypeTrait::Copy(
-                    List<T>::SimpleAllocate(new_size, List<T>::Cap(new_size), nullptr),
+                    List::SimpleAllocate(new_size, List::Cap(new_size)),
                     old,
                     index
             ); // Copy separately~
-            TypeTrait::Copy(first_ + index + count, old + count, old_size - index);
+            TypeTrait::Copy(first_ + index + count, old + index, old_size - index);
         } else {
             SizeType old_capacity = end_ - first_;
-            if (new_size > old_capacity) {
-                SizeType new_capacity = List<T>::Cap(new_size);
+            if (SizeType(first_ - List::Origin()) >= count && index < old_size - index) {
+                // the elements before index are fewer, shift them into the headroom.
+                TypeTrait::Move(first_ - count, first_, index);
+                first_ -= count;
+            } else if (new_size > old_capacity) {
+                SizeType new_capacity = List::Cap(new_size);
                 if (new_capacity - old_capacity > old_capacity * 2) {
+                    RefCount *old_data = data_;
+                    SizeType old_total = end_ - List::Origin();
                     T *old = first_;
-                    TypeTrait::Copy(
-                            List<T>::SimpleAllocate(new_size, new_capacity, *data_),
+                    TypeTrait::Move(
+                            List::SimpleAllocate(new_size, new_capacity),
                             old,
                             index
                     );
-                    TypeTrait::Copy(first_ + index + count, old + index, old_size - index);
+                    TypeTrait::Move(first_ + index + count, old + index, old_size - index);
+                    Allocator::Free(old_data, TotCap(old_total));
                 } else {
-                    T *pos = List<T>::SimpleReallocate(new_size, new_capacity) + index + count;
+                    T *pos = List::SimpleReallocate(new_size, new_capacity) + index;
                     TypeTrait::Move(
-                            pos + index + count,
-                            first_ + index,
+                            pos + count,
+                            pos,
                             old_size - index
                     );
                 }
@@ -968,25 +1378,26 @@ T *List<T>::GrowthInsert(SizeType index, SizeType count) {
     return nullptr;
 }
 
-template<typename T>
-T *List<T>::AssignImpl(SizeType count) {
+template<typename T, typename Allocator, typename Growth, typename Thread>
+T *List<T, Allocator, Growth, Thread>::AssignImpl(SizeType count) {
     if (count) {
         if (data_) {
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
-                return List<T>::SimpleAllocate(count, Cap(count), nullptr);
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
+                return List::SimpleAllocate(count, Cap(count));
             } else {
-                SizeType old_capacity = end_ - first_;
-                for (; last_ != first_; --last_) {
-                    TypeTrait::Destroy(last_);
+                for (; last_ != first_;) {
+                    TypeTrait::Destroy(--last_);
                 }
+                first_ = last_ = List::Origin();
+                SizeType old_capacity = end_ - first_;
                 if (count > old_capacity) {
                     SizeType new_capacity = Cap(count);
                     if (new_capacity - old_capacity > old_capacity * 2) {
                         this->~List();
-                        return List<T>::SimpleAllocate(count, new_capacity, nullptr);
+                        return List::SimpleAllocate(count, new_capacity);
                     } else {
-                        return List<T>::SimpleReallocate(count, new_capacity);
+                        return List::SimpleReallocate(count, new_capacity);
                     }
                 } else {
                     last_ = first_ + count;
@@ -994,7 +1405,7 @@ T *List<T>::AssignImpl(SizeType count) {
                 }
             }
         } else {
-            return List<T>::SimpleAllocate(count, Cap(count), nullptr);
+            return List::SimpleAllocate(count, Cap(count));
         }
     } else {
         Clear();
@@ -1002,4 +1413,14 @@ T *List<T>::AssignImpl(SizeType count) {
     }
 }
 
+namespace Internal {
+    /**
+     * A List only holds pointers to its heap block, thus it can be relocated bitwise.
+     */
+    template<typename T, typename Allocator, typename Growth, typename Thread>
+    struct TypeTraitPatternDefiner<List<T, Allocator, Growth, Thread>> {
+        static const TypeTraitPattern Pattern = TypeTraitPattern::Relocatable;
+    };
+}
+
 #endif //ESCAPIST_LIST_H
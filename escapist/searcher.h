@@ -0,0 +1,290 @@
+/**
+ * Substring search.
+ *
+ * A Searcher preprocesses a needle once, then finds it in any amount of
+ * haystacks. The algorithm is chosen by the length of the needle:
+ *  - 1: a plain character scan, vectorized by internal/simd.h.
+ *  - up to kFilterMax: a SIMD filter on the first and the last character of the
+ *    needle, only the surviving positions are verified.
+ *  - up to kHorspoolMax: Boyer-Moore-Horspool, skipping by the bad-character
+ *    table of the last character in the window.
+ *  - longer: Two-Way, linear in the worst case with constant extra space. Windows
+ *    not ending in the last character of the needle move by the Horspool shift.
+ * ReverseFind mirrors them: the filter, then Horspool, then Two-Way over the reversed needle.
+ *
+ * Bad-character tables are indexed by the low byte of a character, which is exact
+ * for char and still a valid (if smaller) shift for wider characters.
+ */
+
+#ifndef ESCAPIST_SEARCHER_H
+#define ESCAPIST_SEARCHER_H
+
+#include "base.h"
+#include "internal/simd.h"
+#include "internal/type_trait.h"
+#include <cstddef>
+#include <cstring>
+
+/**
+ * The searcher keeps a pointer to the needle, which must outlive it.
+ * @tparam Ch the type of characters
+ */
+template<typename Ch>
+class Searcher {
+public:
+    static constexpr SizeType kFilterMax = 16;
+    static constexpr SizeType kHorspoolMax = 256;
+
+    /**
+     * Preprocesses the needle.
+     * @param needle the first character of the needle
+     * @param len the length of the needle
+     */
+    Searcher(const Ch *needle, SizeType len) : needle_(needle), len_(len) {
+        if (len_ <= 1) {
+            pattern_ = len_ ? Pattern::Single : Pattern::Empty;
+        } else if (Internal::SubstringFilter<Ch>::kAvailable && len_ <= kFilterMax) {
+            pattern_ = Pattern::Filter;
+        } else {
+            pattern_ = len_ <= kHorspoolMax ? Pattern::Horspool : Pattern::TwoWay;
+            Searcher::BuildShifts();
+            if (pattern_ == Pattern::TwoWay) {
+                Searcher::Factorize<false>(forward_);
+                Searcher::Factorize<true>(backward_);
+            }
+        }
+    }
+
+    /**
+     * @return the first occurrence of the needle in [first, last), or nullptr if not found
+     */
+    const Ch *Find(const Ch *first, const Ch *last) const {
+        if (SizeType(last - first) < len_) {
+            return nullptr;
+        }
+        switch (pattern_) {
+            case Pattern::Empty:
+                return first;
+            case Pattern::Single:
+                return Searcher::ElementSearch::Find(first, last, *needle_);
+            case Pattern::Filter:
+                return Internal::SubstringFilter<Ch>::Find(first, last, needle_, len_);
+            case Pattern::Horspool:
+                return Searcher::HorspoolFind(first, last);
+            default:
+                return Searcher::TwoWayFind(first, last);
+        }
+    }
+
+    /**
+     * @return the last occurrence of the needle in [first, last), or nullptr if not found
+     */
+    const Ch *ReverseFind(const Ch *first, const Ch *last) const {
+        if (SizeType(last - first) < len_) {
+            return nullptr;
+        }
+        switch (pattern_) {
+            case Pattern::Empty:
+                return last;
+            case Pattern::Single:
+                return Searcher::ElementSearch::ReverseFind(first, last, *needle_);
+            case Pattern::Filter:
+                return Internal::SubstringFilter<Ch>::ReverseFind(first, last, needle_, len_);
+            case Pattern::Horspool:
+                return Searcher::HorspoolReverseFind(first, last);
+            default:
+                return Searcher::TwoWayReverseFind(first, last);
+        }
+    }
+
+    const Ch *Needle() const noexcept {
+        return needle_;
+    }
+
+    SizeType Length() const noexcept {
+        return len_;
+    }
+
+private:
+    enum class Pattern : short {
+        Empty,
+        Single,
+        Filter,
+        Horspool,
+        TwoWay
+    };
+
+    using ElementSearch = Internal::ElementSearch<Ch, typename Internal::TypeTraitPatternSelector<Ch>::Type>;
+
+    static constexpr SizeType kShiftCount = 256;
+
+    static unsigned char Key(const Ch &ch) noexcept {
+        return static_cast<unsigned char>(ch);
+    }
+
+    /**
+     * shift_[c]: how far the window may move forward when its last character has the key c.
+     * rshift_[c]: how far the window may move backward when its first character has the key c.
+     */
+    void BuildShifts() {
+        for (SizeType i = 0; i < kShiftCount; ++i) {
+            shift_[i] = rshift_[i] = len_;
+        }
+        for (SizeType i = 0; i + 1 < len_; ++i) {
+            shift_[Key(needle_[i])] = len_ - 1 - i;
+        }
+        for (SizeType i = len_ - 1; i > 0; --i) {
+            rshift_[Key(needle_[i])] = i;
+        }
+    }
+
+    const Ch *HorspoolFind(const Ch *first, const Ch *last) const {
+        const Ch back = needle_[len_ - 1];
+        for (const Ch *pos = first, *end = last - len_; pos <= end;) {
+            Ch ch = pos[len_ - 1];
+            if (ch == back && Internal::UnitsEqual(pos, needle_, len_ - 1)) {
+                return pos;
+            }
+            SizeType shift = shift_[Key(ch)];
+            if (SizeType(end - pos) < shift) {
+                break;
+            }
+            pos += shift;
+        }
+        return nullptr;
+    }
+
+    const Ch *HorspoolReverseFind(const Ch *first, const Ch *last) const {
+        const Ch front = needle_[0];
+        for (const Ch *pos = last - len_;;) {
+            Ch ch = *pos;
+            if (ch == front && Internal::UnitsEqual(pos + 1, needle_ + 1, len_ - 1)) {
+                return pos;
+            }
+            SizeType shift = rshift_[Key(ch)];
+            if (SizeType(pos - first) < shift) {
+                return nullptr;
+            }
+            pos -= shift;
+        }
+    }
+
+    /**
+     * The critical factorization of the needle, or of the reversed needle for ReverseFind.
+     */
+    struct Factorization {
+        std::ptrdiff_t split_ = 0; // the end of the left half in Two-Way.
+        std::ptrdiff_t period_ = 0;
+        std::ptrdiff_t memory_ = 0; // the length of the prefix known to match after a periodic shift.
+    };
+
+    /**
+     * @return the character at \p index of the needle, counted from its end if \p kReverse
+     */
+    template<bool kReverse>
+    Ch At(std::ptrdiff_t index) const noexcept {
+        return needle_[kReverse ? std::ptrdiff_t(len_) - 1 - index : index];
+    }
+
+    /**
+     * Computes the critical factorization of the needle, as the longer of the maximal suffixes
+     * under both orderings, and its period. With \p kReverse, the needle is read backwards.
+     */
+    template<bool kReverse>
+    void Factorize(Factorization &rtn) {
+        std::ptrdiff_t len = len_, suffix[2], period[2];
+        for (int order = 0; order < 2; ++order) {
+            std::ptrdiff_t i = -1, j = 0, k = 1, p = 1;
+            while (j + k < len) {
+                Ch a = At<kReverse>(i + k), b = At<kReverse>(j + k);
+                if (a == b) {
+                    if (k == p) {
+                        j += p, k = 1;
+                    } else {
+                        ++k;
+                    }
+                } else if (order ? a < b : a > b) {
+                    j += k, k = 1, p = j - i;
+                } else {
+                    i = j++, k = p = 1;
+                }
+            }
+            suffix[order] = i, period[order] = p;
+        }
+        std::ptrdiff_t pick = suffix[1] > suffix[0] ? 1 : 0;
+        rtn.split_ = suffix[pick];
+        rtn.period_ = period[pick];
+        std::ptrdiff_t k = 0;
+        for (; k <= rtn.split_ && At<kReverse>(k) == At<kReverse>(rtn.period_ + k); ++k);
+        if (k > rtn.split_) {
+            rtn.memory_ = len - rtn.period_; // periodic, the matched prefix is remembered between shifts.
+        } else {
+            rtn.memory_ = 0;
+            rtn.period_ = (rtn.split_ > len - rtn.split_ - 1 ? rtn.split_ : len - rtn.split_ - 1) + 1;
+        }
+    }
+
+    const Ch *TwoWayFind(const Ch *first, const Ch *last) const {
+        std::ptrdiff_t len = len_, memory = 0;
+        for (const Ch *pos = first; last - pos >= len;) {
+            // a window not ending in the last character of the needle moves by the Horspool shift,
+            // as in HorspoolFind. shift_ leaves out that character, which is why it is compared on its own.
+            Ch ch = pos[len - 1];
+            if (ch != needle_[len - 1]) {
+                pos += shift_[Key(ch)], memory = 0;
+                continue;
+            }
+            std::ptrdiff_t split = forward_.split_, k = split + 1 > memory ? split + 1 : memory;
+            for (; k < len && needle_[k] == pos[k]; ++k);
+            if (k < len) {
+                pos += k - split, memory = 0;
+                continue;
+            }
+            for (k = split + 1; k > memory && needle_[k - 1] == pos[k - 1]; --k);
+            if (k <= memory) {
+                return pos;
+            }
+            pos += forward_.period_, memory = forward_.memory_;
+        }
+        return nullptr;
+    }
+
+    /**
+     * TwoWayFind mirrored: the window [end - len, end) moves backwards, and its k-th character
+     * from the end is matched against the k-th character of the needle from its end.
+     */
+    const Ch *TwoWayReverseFind(const Ch *first, const Ch *last) const {
+        std::ptrdiff_t len = len_, memory = 0;
+        for (const Ch *end = last; end - first >= len;) {
+            // a window not starting with the first character of the needle moves by the mirrored
+            // Horspool shift, as in HorspoolReverseFind.
+            Ch ch = end[-len];
+            if (ch != needle_[0]) {
+                end -= rshift_[Key(ch)], memory = 0;
+                continue;
+            }
+            std::ptrdiff_t split = backward_.split_, k = split + 1 > memory ? split + 1 : memory;
+            for (; k < len && needle_[len - 1 - k] == end[-1 - k]; ++k);
+            if (k < len) {
+                end -= k - split, memory = 0;
+                continue;
+            }
+            for (k = split + 1; k > memory && needle_[len - k] == end[-k]; --k);
+            if (k <= memory) {
+                return end - len;
+            }
+            end -= backward_.period_, memory = backward_.memory_;
+        }
+        return nullptr;
+    }
+
+    const Ch *needle_;
+    SizeType len_;
+    Pattern pattern_;
+    Factorization forward_;
+    Factorization backward_;
+    SizeType shift_[kShiftCount];
+    SizeType rshift_[kShiftCount];
+};
+
+#endif //ESCAPIST_SEARCHER_H
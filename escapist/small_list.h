@@ -0,0 +1,344 @@
+/**
+ * A List with inline storage.
+ *
+ * SmallList keeps up to N elements inside the instance, like the small buffer of
+ * BasicString, so that short lists never touch the heap. Once it outgrows them, the
+ * elements move into a List and every call is forwarded to it, with its copy-on-write
+ * heap block, growth and thread policies. A spilled instance never moves back inline.
+ *
+ * It offers the everyday part of the List interface, implemented over the same
+ * TypeTrait and internal range algorithms.
+ */
+
+#ifndef ESCAPIST_SMALL_LIST_H
+#define ESCAPIST_SMALL_LIST_H
+
+#include <initializer_list>
+#include <new>
+#include <utility>
+#include "base.h"
+#include "list.h"
+
+/**
+ * @tparam T the type of elements
+ * @tparam N the amount of elements stored inline
+ * @tparam Allocator the allocation policy of the spilled block, see allocator.h
+ * @tparam Growth the growth policy of the spilled block, see growth.h
+ * @tparam Thread the thread policy of the spilled block, see thread_policy.h
+ */
+template<typename T, SizeType N, typename Allocator = MallocAllocator, typename Growth = HalfGrowth,
+         typename Thread = MultiThreadPolicy>
+class SmallList {
+public:
+    using Storage = List<T, Allocator, Growth, Thread>;
+    using TypeTrait = typename Storage::TypeTrait;
+    using RangeIterator = Internal::RangeIterator<T>;
+    using ConstRangeIterator = Internal::RangeIterator<const T>;
+
+    static_assert(N > 0, "a SmallList needs room for at least one element");
+
+    static constexpr SizeType kInlineCap = N;
+
+    SmallList() noexcept: count_(0) {}
+
+    SmallList(std::initializer_list<T> init) : SmallList() {
+        if (init.size()) {
+            TypeTrait::Copy(SmallList::GrowthInsert(0, init.size()), init.begin(), init.size());
+        }
+    }
+
+    /**
+     * Copies the inline elements, or shares the spilled block of \p other.
+     */
+    SmallList(const SmallList &other) : count_(other.count_) {
+        if (other.IsSmall()) {
+            TypeTrait::Copy(SmallList::Inline(), other.Inline(), count_);
+        } else {
+            new(&list_)Storage(other.list_);
+        }
+    }
+
+    SmallList(SmallList &&other) noexcept: count_(other.count_) {
+        if (other.IsSmall()) {
+            TypeTrait::Move(SmallList::Inline(), other.Inline(), count_);
+        } else {
+            new(&list_)Storage(std::move(other.list_));
+            other.list_.~Storage();
+        }
+        other.count_ = 0;
+    }
+
+    SmallList &operator=(const SmallList &other) = delete;
+
+    ~SmallList() {
+        if (IsSmall()) {
+            for (T *pos = SmallList::Inline(), *last = pos + count_; pos != last; ++pos) {
+                TypeTrait::Destroy(pos);
+            }
+        } else {
+            list_.~Storage();
+        }
+    }
+
+    /**
+     * @return true if the elements are stored inside the instance
+     */
+    bool IsSmall() const noexcept {
+        return count_ != kSpilled;
+    }
+
+    SizeType Count() const noexcept {
+        return IsSmall() ? count_ : list_.Count();
+    }
+
+    SizeType Capacity() const noexcept {
+        return IsSmall() ? N : list_.Capacity();
+    }
+
+    bool IsEmpty() const noexcept {
+        return !Count();
+    }
+
+    /**
+     * @return the first element, after detaching a shared block
+     */
+    T *Data() {
+        return IsSmall() ? SmallList::Inline() : list_.Data();
+    }
+
+    const T *ConstData() const noexcept {
+        return IsSmall() ? SmallList::Inline() : list_.ConstData();
+    }
+
+    T &At(SizeType index) {
+        assert(index < Count());
+        return SmallList::Data()[index];
+    }
+
+    const T &ConstAt(SizeType index) const {
+        assert(index < Count());
+        return ConstData()[index];
+    }
+
+    SmallList &SetAt(SizeType index, const T &value) {
+        T copy(value), *pos = &SmallList::At(index); // value may be the element itself.
+        TypeTrait::Destroy(pos);
+        TypeTrait::Assign(pos, std::move(copy));
+        return *this;
+    }
+
+    SmallList &Append(const T &value) {
+        TypeTrait::Assign(SmallList::GrowthInsert(Count(), 1), value);
+        return *this;
+    }
+
+    SmallList &Append(T &&value) {
+        TypeTrait::Assign(SmallList::GrowthInsert(Count(), 1), std::move(value));
+        return *this;
+    }
+
+    SmallList &Append(const T *data, SizeType count) {
+        if (count) {
+            TypeTrait::Copy(SmallList::GrowthInsert(Count(), count), data, count);
+        }
+        return *this;
+    }
+
+    template<typename... Args>
+    SmallList &Emplace(Args &&... args) {
+        new(SmallList::GrowthInsert(Count(), 1))T(std::forward<Args>(args)...);
+        return *this;
+    }
+
+    SmallList &Prepend(const T &value) {
+        TypeTrait::Assign(SmallList::GrowthInsert(0, 1), value);
+        return *this;
+    }
+
+    SmallList &Prepend(T &&value) {
+        TypeTrait::Assign(SmallList::GrowthInsert(0, 1), std::move(value));
+        return *this;
+    }
+
+    /**
+     * @param index the position, no larger than the amount of elements
+     */
+    SmallList &Insert(SizeType index, const T &value) {
+        TypeTrait::Assign(SmallList::GrowthInsert(index, 1), value);
+        return *this;
+    }
+
+    SmallList &Insert(SizeType index, T &&value) {
+        TypeTrait::Assign(SmallList::GrowthInsert(index, 1), std::move(value));
+        return *this;
+    }
+
+    SmallList &Remove(SizeType index, SizeType count = 1) {
+        if (!IsSmall()) {
+            list_.Remove(index, count);
+            return *this;
+        }
+        assert(index + count <= count_);
+        T *pos = SmallList::Inline() + index;
+        for (SizeType i = 0; i < count; ++i) {
+            TypeTrait::Destroy(pos + i);
+        }
+        TypeTrait::Move(pos, pos + count, count_ - index - count);
+        count_ -= count;
+        return *this;
+    }
+
+    /**
+     * Removes every element. A spilled instance keeps its block.
+     */
+    SmallList &Clear() {
+        if (IsSmall()) {
+            SmallList::Remove(0, count_);
+        } else {
+            list_.Clear();
+        }
+        return *this;
+    }
+
+    /**
+     * Makes room for at least \p capacity elements, spilling to the heap if they do not fit inline.
+     */
+    SmallList &Reserve(SizeType capacity) {
+        if (!IsSmall()) {
+            list_.Reserve(capacity);
+        } else if (capacity > N) {
+            SmallList::Spill(capacity, count_, 0);
+        }
+        return *this;
+    }
+
+    template<typename Equal = Internal::EqualTo<T>>
+    bool Equals(const SmallList &other, Equal equal = Equal()) const {
+        return Count() == other.Count() && Internal::RangeEquals(ConstData(), other.ConstData(), Count(), equal);
+    }
+
+    template<typename Compare = Internal::ThreeWayCompare<T>>
+    int CompareTo(const SmallList &other, Compare compare = Compare()) const {
+        return Internal::RangeCompareTo(ConstData(), Count(), other.ConstData(), other.Count(), compare);
+    }
+
+    SizeType IndexOf(const T &value, SizeType from = 0) const {
+        SizeType size = Count();
+        if (from >= size) {
+            return SizeType(-1);
+        }
+        const T *data = ConstData();
+        const T *pos = Internal::ElementSearch<T, TypeTrait>::Find(data + from, data + size, value);
+        return pos ? SizeType(pos - data) : SizeType(-1);
+    }
+
+    SizeType LastIndexOf(const T &value, SizeType before = SizeType(-1)) const {
+        SizeType size = Count();
+        if (before > size) {
+            before = size;
+        }
+        const T *data = ConstData();
+        const T *pos = Internal::ElementSearch<T, TypeTrait>::ReverseFind(data, data + before, value);
+        return pos ? SizeType(pos - data) : SizeType(-1);
+    }
+
+    bool Contains(const T &value) const {
+        return IndexOf(value) != SizeType(-1);
+    }
+
+    SizeType CountOf(const T &value) const {
+        const T *data = ConstData();
+        return Internal::ElementSearch<T, TypeTrait>::Count(data, data + Count(), value);
+    }
+
+    SizeType Hash() const {
+        return SizeType(Internal::RangeHash(ConstData(), Count()));
+    }
+
+    template<typename Compare = Internal::LessThan<T>>
+    SmallList &Sort(Compare compare = Compare()) {
+        if (SizeType size = Count()) {
+            T *data = SmallList::Data();
+            Internal::Sorter<T, TypeTrait, Compare>::Sort(data, data + size, compare);
+        }
+        return *this;
+    }
+
+    // See List::begin.
+    RangeIterator begin() {
+        T *data = SmallList::Data();
+        return Internal::MakeRangeIterator(data, data, data + Count());
+    }
+
+    RangeIterator end() {
+        T *data = SmallList::Data();
+        return Internal::MakeRangeIterator(data + Count(), data, data + Count());
+    }
+
+    ConstRangeIterator begin() const noexcept {
+        const T *data = ConstData();
+        return Internal::MakeRangeIterator(data, data, data + Count());
+    }
+
+    ConstRangeIterator end() const noexcept {
+        const T *data = ConstData();
+        return Internal::MakeRangeIterator(data + Count(), data, data + Count());
+    }
+
+private:
+    // count_ of a spilled instance, whose elements live in list_.
+    static constexpr SizeType kSpilled = SizeType(-1);
+
+    T *Inline() noexcept {
+        return reinterpret_cast<T *>(buffer_);
+    }
+
+    const T *Inline() const noexcept {
+        return reinterpret_cast<const T *>(buffer_);
+    }
+
+    /**
+     * Opens \p count uninitialized slots at \p index, spilling to the heap if they do not fit inline.
+     * @return the address of the first slot
+     */
+    T *GrowthInsert(SizeType index, SizeType count) {
+        if (!IsSmall()) {
+            SizeType size = list_.Count();
+            if (index == size) {
+                return list_.GrowthAppend(count);
+            }
+            return index ? list_.GrowthInsert(index, count) : list_.GrowthPrepend(count);
+        }
+        assert(index <= count_);
+        if (count_ + count <= N) {
+            T *pos = SmallList::Inline() + index;
+            TypeTrait::Move(pos + count, pos, count_ - index);
+            count_ += count;
+            return pos;
+        }
+        SmallList::Spill(count_ + count, index, count);
+        return list_.first_ + index;
+    }
+
+    /**
+     * Moves the inline elements into a List block for at least \p capacity elements,
+     * leaving \p gap uninitialized slots at \p index, which the caller fills.
+     */
+    void Spill(SizeType capacity, SizeType index, SizeType gap) {
+        Storage list;
+        list.Reserve(capacity);
+        TypeTrait::Move(list.first_, SmallList::Inline(), index);
+        TypeTrait::Move(list.first_ + index + gap, SmallList::Inline() + index, count_ - index);
+        list.last_ = list.first_ + count_ + gap;
+        new(&list_)Storage(std::move(list));
+        count_ = kSpilled;
+    }
+
+    union {
+        Storage list_;
+        alignas(T) unsigned char buffer_[N * sizeof(T)];
+    };
+    SizeType count_;
+};
+
+#endif //ESCAPIST_SMALL_LIST_H
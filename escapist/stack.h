@@ -0,0 +1,300 @@
+/**
+ * Last-in first-out stacks.
+ *
+ * Two stacks are provided:
+ *  - Stack: a growable stack keeping its elements in the contiguous block of a List.
+ *    The List is never shared, thus Push and Pop skip the copy-on-write checks of
+ *    the List and only compare the top against the end of the block.
+ *  - InlineStack: a stack of at most N elements living inside the instance, which
+ *    never touches the heap. Meant for small stacks in hot loops, such as the operator
+ *    stack of an expression evaluator.
+ * Elements are handled through TypeTrait, just like in List.
+ */
+
+#ifndef ESCAPIST_STACK_H
+#define ESCAPIST_STACK_H
+
+#include "base.h"
+#include "thread_policy.h"
+#include "allocator.h"
+#include "growth.h"
+#include "list.h"
+#include <cassert>
+#include <new>
+#include <utility>
+
+/**
+ * Copying a stack copies its elements, it is never shared.
+ * @tparam T the type of elements
+ * @tparam Allocator the allocation policy of the memory block, see allocator.h
+ * @tparam Growth the growth policy deciding the capacity of a new block, see growth.h
+ */
+template<typename T, typename Allocator = MallocAllocator, typename Growth = HalfGrowth>
+class Stack {
+public:
+    using Storage = List<T, Allocator, Growth, UnsharedPolicy>;
+    using TypeTrait = typename Storage::TypeTrait;
+
+    Stack() = default;
+
+    Stack(const Stack &other) = default;
+
+    Stack(Stack &&other) noexcept = default;
+
+    /**
+     * Replaces the elements with copies of those of \p other.
+     * The copy is made first, thus the stack is left unchanged if copying an element throws.
+     */
+    Stack &operator=(const Stack &other) {
+        if (&other != this) {
+            Storage copy(other.list_);
+            list_.~Storage();
+            new(&list_)Storage(std::move(copy));
+        }
+        return *this;
+    }
+
+    Stack &operator=(Stack &&other) noexcept {
+        if (&other != this) {
+            list_.~Storage();
+            new(&list_)Storage(std::move(other.list_));
+        }
+        return *this;
+    }
+
+    SizeType Count() const noexcept {
+        return list_.Count();
+    }
+
+    bool IsEmpty() const noexcept {
+        return list_.last_ == list_.first_;
+    }
+
+    /**
+     * @return the element on the top, the stack must not be empty
+     */
+    T &Top() noexcept {
+        assert(!IsEmpty());
+        return list_.last_[-1];
+    }
+
+    const T &Top() const noexcept {
+        assert(!IsEmpty());
+        return list_.last_[-1];
+    }
+
+    /**
+     * @param value the new top, which may be an element of the stack, such as Top()
+     */
+    Stack &Push(const T &value) {
+        if (list_.last_ != list_.end_) {
+            TypeTrait::Assign(list_.last_, value);
+        } else {
+            T copy(value); // value may live in the block which the growth is about to free.
+            TypeTrait::Assign(Stack::Slot(1), std::move(copy));
+        }
+        ++list_.last_;
+        return *this;
+    }
+
+    Stack &Push(T &&value) {
+        if (list_.last_ != list_.end_) {
+            TypeTrait::Assign(list_.last_, std::move(value));
+        } else {
+            T moved(std::move(value));
+            TypeTrait::Assign(Stack::Slot(1), std::move(moved));
+        }
+        ++list_.last_;
+        return *this;
+    }
+
+    /**
+     * Constructs an element on the top in place, forwarding \p args to the constructor of \c T.
+     * Like Push, \p args may refer to elements of the stack.
+     */
+    template<typename... Args>
+    Stack &Emplace(Args &&... args) {
+        if (list_.last_ != list_.end_) {
+            new(list_.last_)T(std::forward<Args>(args)...);
+        } else {
+            T element(std::forward<Args>(args)...);
+            TypeTrait::Assign(Stack::Slot(1), std::move(element));
+        }
+        ++list_.last_;
+        return *this;
+    }
+
+    /**
+     * Pushes \p count elements starting from \p data, the last one ends up on the top.
+     * The block grows at most once, thus \p data must not point into the stack.
+     */
+    Stack &PushRange(const T *data, SizeType count) {
+        if (count) {
+            TypeTrait::Copy(Stack::Slot(count), data, count);
+            list_.last_ += count;
+        }
+        return *this;
+    }
+
+    /**
+     * Removes the element on the top, the stack must not be empty.
+     * @return the removed element
+     */
+    T Pop() {
+        assert(!IsEmpty());
+        T rtn(std::move(*--list_.last_));
+        TypeTrait::Destroy(list_.last_);
+        return rtn;
+    }
+
+    /**
+     * Removes the top \p count elements without returning them.
+     */
+    Stack &Discard(SizeType count = 1) {
+        assert(count <= Count());
+        for (; count > 0; --count) {
+            TypeTrait::Destroy(--list_.last_);
+        }
+        return *this;
+    }
+
+    /**
+     * Makes room for \p capacity elements in total, so that pushing up to that amount does not reallocate.
+     */
+    Stack &Reserve(SizeType capacity) {
+        list_.Reserve(capacity);
+        return *this;
+    }
+
+    Stack &Clear() {
+        list_.Clear();
+        return *this;
+    }
+
+    /**
+     * @return the elements from the bottom to the top
+     */
+    const T *ConstData() const noexcept {
+        return list_.first_;
+    }
+
+private:
+    /**
+     * @return the uninitialized slots above the top for \p count elements, growing the block if needed
+     */
+    T *Slot(SizeType count) {
+        if (SizeType(list_.end_ - list_.last_) < count) {
+            list_.Reserve(list_.Count() + count);
+        }
+        return list_.last_;
+    }
+
+    Storage list_;
+};
+
+/**
+ * A stack of at most \p N elements, stored inside the instance.
+ * Pushing onto a full stack is a bug, which is only checked by assert.
+ * @tparam T the type of elements
+ * @tparam N the capacity
+ */
+template<typename T, SizeType N>
+class InlineStack {
+public:
+    using TypeTrait = typename Internal::TypeTraitPatternSelector<T>::Type;
+
+    static constexpr SizeType kCapacity = N;
+
+    InlineStack() noexcept : last_(InlineStack::Origin()) {}
+
+    InlineStack(const InlineStack &other) : last_(InlineStack::Origin() + other.Count()) {
+        TypeTrait::Copy(InlineStack::Origin(), other.ConstData(), other.Count());
+    }
+
+    InlineStack &operator=(const InlineStack &other) = delete;
+
+    ~InlineStack() {
+        Clear();
+    }
+
+    SizeType Count() const noexcept {
+        return last_ - ConstData();
+    }
+
+    bool IsEmpty() const noexcept {
+        return last_ == ConstData();
+    }
+
+    bool IsFull() const noexcept {
+        return Count() == N;
+    }
+
+    T &Top() noexcept {
+        assert(!IsEmpty());
+        return last_[-1];
+    }
+
+    const T &Top() const noexcept {
+        assert(!IsEmpty());
+        return last_[-1];
+    }
+
+    InlineStack &Push(const T &value) {
+        assert(!IsFull());
+        TypeTrait::Assign(last_++, value);
+        return *this;
+    }
+
+    InlineStack &Push(T &&value) {
+        assert(!IsFull());
+        TypeTrait::Assign(last_++, std::move(value));
+        return *this;
+    }
+
+    template<typename... Args>
+    InlineStack &Emplace(Args &&... args) {
+        assert(!IsFull());
+        new(last_++)T(std::forward<Args>(args)...);
+        return *this;
+    }
+
+    InlineStack &PushRange(const T *data, SizeType count) {
+        assert(count <= N - Count());
+        TypeTrait::Copy(last_, data, count);
+        last_ += count;
+        return *this;
+    }
+
+    T Pop() {
+        assert(!IsEmpty());
+        T rtn(std::move(*--last_));
+        TypeTrait::Destroy(last_);
+        return rtn;
+    }
+
+    InlineStack &Discard(SizeType count = 1) {
+        assert(count <= Count());
+        for (; count > 0; --count) {
+            TypeTrait::Destroy(--last_);
+        }
+        return *this;
+    }
+
+    InlineStack &Clear() {
+        return Discard(Count());
+    }
+
+    const T *ConstData() const noexcept {
+        return reinterpret_cast<const T *>(buffer_);
+    }
+
+private:
+    T *Origin() noexcept {
+        return reinterpret_cast<T *>(buffer_);
+    }
+
+    alignas(T) unsigned char buffer_[N * sizeof(T)];
+    T *last_;
+};
+
+#endif //ESCAPIST_STACK_H
@@ -6,13 +6,27 @@
 #define ESCAPIST_STRING_H
 
 #include "base.h"
-#include "internal/ref_count.h"
+#include "thread_policy.h"
+#include "internal/type_trait.h"
+#include "internal/compare.h"
+#include "internal/hash.h"
+#include "internal/simd.h"
+#include "searcher.h"
 #include <type_traits>
+#include <atomic>
+#include <functional>
+#include <locale>
 #include <memory>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
 
+/**
+ * Operations on strings of code units.
+ * Integral code units of 1, 2 or 4 bytes, such as char16_t and char32_t, are scanned by
+ * SSE2/AVX2 kernels selected at runtime, see internal/simd.h.
+ * \c char and \c wchar_t are specialized onto the C library instead.
+ */
 template<typename Ch>
 struct ICharTrait {
     /**
@@ -22,9 +36,9 @@ struct ICharTrait {
      * @param count how many characters to be copied.
      */
     static inline void Copy(Ch *dest, const Ch *src, SizeType count) {
-        assert(dest && src && count);
-        for (; count > 0; ++dest, ++src, --count) {
-            *dest = *src;
+        if (count) {
+            assert(dest && src);
+            ::memcpy(dest, src, count * sizeof(Ch));
         }
     }
 
@@ -36,16 +50,9 @@ struct ICharTrait {
      * @param count how many characters to be copied.
      */
     static inline void Move(Ch *dest, const Ch *src, SizeType count) {
-        assert(dest && src && count);
-        if ((dest <= src) || (dest > src + count)) {
-            for (; count; ++dest, ++src, --count) {
-                *dest = *src;
-            }
-        } else {
-            dest = dest + count - 1;
-            src = src + count - 1;
-            for (; count; --dest, --src, --count)
-                *dest = *src;
+        if (count) {
+            assert(dest && src);
+            ::memmove(dest, src, count * sizeof(Ch));
         }
     }
 
@@ -56,9 +63,7 @@ struct ICharTrait {
      * @param count how many {val} to be filled.
      */
     static inline void Fill(Ch *dest, const Ch &val, SizeType count) {
-        for (; count > 0; ++dest, --count) {
-            *dest = val;
-        }
+        Internal::CharKernel<Ch>::Fill(dest, val, count);
     }
 
     /**
@@ -66,9 +71,17 @@ struct ICharTrait {
      * @return the length if the given string
      */
     static inline SizeType Length(const Ch *src) {
-        SizeType len = 0;
-        for (; *src; ++src, ++len);
-        return len;
+        return Internal::CharKernel<Ch>::Scan(src, Ch()) - src;
+    }
+
+    /**
+     * @param src null-terminated string
+     * @param count maximum amount of characters to examine.
+     * @return the length of the given string, or \p count if no terminator occurs in the first \p count characters
+     */
+    static inline SizeType Length(const Ch *src, SizeType count) {
+        const Ch *end = Internal::CharKernel<Ch>::Scan(src, Ch(), count);
+        return end ? end - src : count;
     }
 
     /**
@@ -82,8 +95,7 @@ struct ICharTrait {
         if (left == right) {
             return 0;
         }
-        for (; *left && *right && *left == *right; ++left, ++right);
-        return *left - *right;
+        return Internal::CharKernel<Ch>::Compare(left, right, SizeType(-1));
     }
 
     /**
@@ -94,44 +106,71 @@ struct ICharTrait {
      * @return zero if the first {count} of characters of two strings are equal
      */
     static inline int Compare(const Ch *left, const Ch *right, SizeType count) {
-        assert(left && right && count);
+        assert(left && right);
         // Terminate if some strings terminate,
         // or the one does not equal to another,
         // or the maximum count reaches.
-        for (; *left && *right && *left == *right && count; ++left, ++right, --count);
-        return *left - *right;
+        return Internal::CharKernel<Ch>::Compare(left, right, count);
     }
 
     /**
      * Compare between {left} string and {right} string,
-     * but ignore the case.
+     * but ignore the case of ASCII letters.
      * @param left the first null-terminated string
      * @param right the second null-terminated string
      * @return zero two strings are equal
-     * TODO: find a more efficient way!!!
      */
     static inline int CompareNoCase(const Ch *left, const Ch *right) {
         assert(left && right);
         if (left == right) {
             return 0;
         }
-        for (; *left && *right && tolower(*left) == tolower(*right); ++left, ++right);
-        return *left - *right;
+        return ICharTrait<Ch>::CompareNoCase(left, ICharTrait<Ch>::Length(left),
+                                             right, ICharTrait<Ch>::Length(right));
     }
 
     /**
      * Compare the first \p count characters between {left} string and {right} string,
-     * but ignore the case.
+     * but ignore the case of ASCII letters.
      * @param left the first null-terminated string
      * @param right the second null-terminated string
      * @param count the maximum count of compared characters.
      * @return zero if the first {count} of characters of two strings are equal
-     * TODO: find a more efficient way!!!
      */
     static inline int CompareNoCase(const Ch *left, const Ch *right, SizeType count) {
         assert(left && right);
-        for (; *left && *right && tolower(*left) == tolower(*right) && count; ++left, ++right, --count);
-        return *left - *right;
+        return ICharTrait<Ch>::CompareNoCase(left, ICharTrait<Ch>::Length(left, count),
+                                             right, ICharTrait<Ch>::Length(right, count));
+    }
+
+    /**
+     * Compare the first \p left_len characters of \p left with the first \p right_len characters of \p right,
+     * null characters included, but ignore the case of ASCII letters. Other characters are compared as they are,
+     * thus the result does not depend on the locale.
+     * @return zero if two ranges are equal
+     */
+    static inline int CompareNoCase(const Ch *left, SizeType left_len, const Ch *right, SizeType right_len) {
+        SizeType count = left_len < right_len ? left_len : right_len;
+        SizeType index = Internal::AsciiCase<Ch>::FoldedMismatch(left, right, count);
+        if (index < count) {
+            return Internal::CompareUnit(Internal::AsciiToLower(left[index]),
+                                         Internal::AsciiToLower(right[index]));
+        }
+        return left_len < right_len ? -1 : (left_len > right_len ? 1 : 0);
+    }
+
+    /**
+     * Convert the ASCII letters among the first \p count characters of \p src to lower case.
+     */
+    static inline void ToLower(Ch *src, SizeType count) {
+        Internal::AsciiCase<Ch>::ToLower(src, count);
+    }
+
+    /**
+     * Convert the ASCII letters among the first \p count characters of \p src to upper case.
+     */
+    static inline void ToUpper(Ch *src, SizeType count) {
+        Internal::AsciiCase<Ch>::ToUpper(src, count);
     }
 
     /**
@@ -142,12 +181,8 @@ struct ICharTrait {
      */
     static inline const Ch *Find(const Ch *src, const Ch &val) {
         assert(src);
-        for (; *src; ++src) {
-            if (*src == val) {
-                return src;
-            }
-        }
-        return nullptr;
+        const Ch *pos = Internal::CharKernel<Ch>::Scan(src, val);
+        return *pos == val ? pos : nullptr;
     }
 
     /**
@@ -158,13 +193,9 @@ struct ICharTrait {
      * @return pointer to found character if found; nullptr if no such character is found.
      */
     static inline const Ch *Find(const Ch *src, const Ch &val, SizeType count) {
-        assert(src && count);
-        for (; *src && count; ++src, --count) {
-            if (*src == val) {
-                return src;
-            }
-        }
-        return nullptr;
+        assert(src);
+        const Ch *pos = Internal::CharKernel<Ch>::Scan(src, val, count);
+        return pos && *pos == val ? pos : nullptr;
     }
 
     /**
@@ -178,17 +209,8 @@ struct ICharTrait {
         if (!sub) {
             return nullptr;
         }
-        for (; *src; ++src) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const Ch *src_ref = src, // prevent {src} from changing to ensure every char is scanned.
-                *sub_ref = sub; // also make a copy of {sub} to go back if it doesn't match.
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref; ++src_ref, ++sub_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    return src; // Thus, return it!
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return nullptr;
+        const Ch *end = src + ICharTrait<Ch>::Length(src);
+        return Searcher<Ch>(sub, ICharTrait<Ch>::Length(sub)).Find(src, end);
     }
 
     /**
@@ -203,18 +225,8 @@ struct ICharTrait {
         if (!sub) {
             return nullptr;
         }
-        for (; *src && count; ++src, --count) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const Ch *src_ref = src, // prevent {src} from changing to ensure every char is scanned.
-                *sub_ref = sub; // also make a copy of {sub} to go back if it doesn't match.
-                SizeType count_ref = count;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref && count_ref; ++src_ref, ++sub_ref, --count_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    return src; // Thus, return it!
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return nullptr;
+        const Ch *end = src + ICharTrait<Ch>::Length(src, count);
+        return Searcher<Ch>(sub, ICharTrait<Ch>::Length(sub)).Find(src, end);
     }
 
     /**
@@ -225,13 +237,7 @@ struct ICharTrait {
      */
     static inline const Ch *ReverseFind(const Ch *src, const Ch &val) {
         assert(src);
-        const Ch *last = nullptr;
-        for (; *src; ++src) {
-            if (*src == val) {
-                last = src;
-            }
-        }
-        return last;
+        return ICharTrait<Ch>::ReverseFindIn(src, ICharTrait<Ch>::Length(src), val);
     }
 
     /**
@@ -242,14 +248,9 @@ struct ICharTrait {
      * @return pointer to found character if found; nullptr if no such character is found.
      */
     static inline const Ch *ReverseFind(const Ch *src, const Ch &val, SizeType count) {
-        assert(src && count);
-        const Ch *last = nullptr;
-        for (; *src && count; ++src, --count) {
-            if (*src == val) {
-                last = src;
-            }
-        }
-        return last;
+        assert(src);
+        const Ch *end = Internal::CharKernel<Ch>::Scan(src, Ch(), count);
+        return ICharTrait<Ch>::ReverseFindIn(src, end ? end - src : count, val);
     }
 
     /**
@@ -263,18 +264,8 @@ struct ICharTrait {
         if (!sub) {
             return nullptr;
         }
-        const Ch *last = nullptr;
-        for (; *src; ++src) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const Ch *src_ref = src,
-                        *sub_ref = sub;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref; ++src_ref, ++sub_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    last = src;
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return last;
+        const Ch *end = src + ICharTrait<Ch>::Length(src);
+        return Searcher<Ch>(sub, ICharTrait<Ch>::Length(sub)).ReverseFind(src, end);
     }
 
     /**
@@ -289,19 +280,34 @@ struct ICharTrait {
         if (!sub) {
             return nullptr;
         }
-        const Ch *last = nullptr;
-        for (; *src && count; ++src, --count) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const Ch *src_ref = src,
-                        *sub_ref = sub;
-                SizeType count_ref = count;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref && count_ref; ++src_ref, ++sub_ref, --count_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    last = src;
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return last;
+        const Ch *end = src + ICharTrait<Ch>::Length(src, count);
+        return Searcher<Ch>(sub, ICharTrait<Ch>::Length(sub)).ReverseFind(src, end);
+    }
+
+    /**
+     * Compare the first \p left_len characters of \p left with the first \p right_len characters of \p right,
+     * null characters included. A range goes first if it is a prefix of the other.
+     * @return zero if two ranges are equal
+     */
+    static inline int Compare(const Ch *left, SizeType left_len, const Ch *right, SizeType right_len) {
+        Internal::ThreeWayCompare<Ch> compare;
+        return Internal::RangeCompareTo(left, left_len, right, right_len, compare);
+    }
+
+    /**
+     * Find the first occurrence of \p val among the first \p len characters of \p src, terminators included.
+     */
+    static inline const Ch *FindIn(const Ch *src, SizeType len, const Ch &val) {
+        return Internal::ElementSearch<Ch, typename Internal::TypeTraitPatternSelector<Ch>::Type>::Find(
+                src, src + len, val);
+    }
+
+    /**
+     * Find the last occurrence of \p val among the first \p len characters of \p src, terminators included.
+     */
+    static inline const Ch *ReverseFindIn(const Ch *src, SizeType len, const Ch &val) {
+        return Internal::ElementSearch<Ch, typename Internal::TypeTraitPatternSelector<Ch>::Type>::ReverseFind(
+                src, src + len, val);
     }
 
     // TODO: Find & ReverseFind Ignore Case
@@ -374,6 +380,15 @@ struct ICharTrait<char> {
         return ::strlen(src);
     }
 
+    /**
+     * @param src null-terminated string
+     * @param count maximum amount of characters to examine.
+     * @return the length of the given string, or \p count if no terminator occurs in the first \p count characters
+     */
+    static inline SizeType Length(const char *src, SizeType count) {
+        return ::strnlen(src, count);
+    }
+
     /**
      * Compare between {left} string and {right} string.
      * @param left the first null-terminated string
@@ -401,7 +416,6 @@ struct ICharTrait<char> {
      * @param left the first null-terminated string
      * @param right the second null-terminated string
      * @return zero two strings are equal
-     * TODO: find a more efficient way!!!
      */
     static inline int CompareNoCase(const char *left, const char *right) {
         return ::strcasecmp(left, right);
@@ -414,12 +428,39 @@ struct ICharTrait<char> {
      * @param right the second null-terminated string
      * @param count the maximum count of compared characters.
      * @return zero if the first {count} of characters of two strings are equal
-     * TODO: find a more efficient way!!!
      */
     static inline int CompareNoCase(const char *left, const char *right, SizeType count) {
-        assert(left && right);
-        for (; *left && *right && tolower(*left) == tolower(*right) && count; ++left, ++right, --count);
-        return *left - *right;
+        return ::strncasecmp(left, right, count);
+    }
+
+    /**
+     * Compare the first \p left_len characters of \p left with the first \p right_len characters of \p right,
+     * null characters included, but ignore the case of ASCII letters. Other characters are compared as they are,
+     * thus the result does not depend on the locale.
+     * @return zero if two ranges are equal
+     */
+    static inline int CompareNoCase(const char *left, SizeType left_len, const char *right, SizeType right_len) {
+        SizeType count = left_len < right_len ? left_len : right_len;
+        SizeType index = Internal::AsciiCase<char>::FoldedMismatch(left, right, count);
+        if (index < count) {
+            return Internal::CompareUnit(static_cast<unsigned char>(Internal::AsciiToLower(left[index])),
+                                         static_cast<unsigned char>(Internal::AsciiToLower(right[index])));
+        }
+        return left_len < right_len ? -1 : (left_len > right_len ? 1 : 0);
+    }
+
+    /**
+     * Convert the ASCII letters among the first \p count characters of \p src to lower case.
+     */
+    static inline void ToLower(char *src, SizeType count) {
+        Internal::AsciiCase<char>::ToLower(src, count);
+    }
+
+    /**
+     * Convert the ASCII letters among the first \p count characters of \p src to upper case.
+     */
+    static inline void ToUpper(char *src, SizeType count) {
+        Internal::AsciiCase<char>::ToUpper(src, count);
     }
 
     /**
@@ -471,18 +512,8 @@ struct ICharTrait<char> {
         if (!sub) {
             return nullptr;
         }
-        for (; *src && count; ++src, --count) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const char *src_ref = src, // prevent {src} from changing to ensure every char is scanned.
-                *sub_ref = sub; // also make a copy of {sub} to go back if it doesn't match.
-                SizeType count_ref = count;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref && count_ref; ++src_ref, ++sub_ref, --count_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    return src; // Thus, return it!
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return nullptr;
+        const char *end = src + ICharTrait<char>::Length(src, count);
+        return Searcher<char>(sub, ICharTrait<char>::Length(sub)).Find(src, end);
     }
 
     /**
@@ -524,18 +555,8 @@ struct ICharTrait<char> {
         if (!sub) {
             return nullptr;
         }
-        const char *last = nullptr;
-        for (; *src; ++src) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const char *src_ref = src,
-                        *sub_ref = sub;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref; ++src_ref, ++sub_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    last = src;
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return last;
+        const char *end = src + ICharTrait<char>::Length(src);
+        return Searcher<char>(sub, ICharTrait<char>::Length(sub)).ReverseFind(src, end);
     }
 
     /**
@@ -550,19 +571,36 @@ struct ICharTrait<char> {
         if (!sub) {
             return nullptr;
         }
-        const char *last = nullptr;
-        for (; *src && count; ++src, --count) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const char *src_ref = src,
-                        *sub_ref = sub;
-                SizeType count_ref = count;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref && count_ref; ++src_ref, ++sub_ref, --count_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    last = src;
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
+        const char *end = src + ICharTrait<char>::Length(src, count);
+        return Searcher<char>(sub, ICharTrait<char>::Length(sub)).ReverseFind(src, end);
+    }
+
+    /**
+     * Compare the first \p left_len characters of \p left with the first \p right_len characters of \p right,
+     * null characters included. A range goes first if it is a prefix of the other.
+     * @return zero if two ranges are equal
+     */
+    static inline int Compare(const char *left, SizeType left_len, const char *right, SizeType right_len) {
+        SizeType count = left_len < right_len ? left_len : right_len;
+        if (int rtn = count ? ::memcmp(left, right, count) : 0) {
+            return rtn;
         }
-        return last;
+        return left_len < right_len ? -1 : (left_len > right_len ? 1 : 0);
+    }
+
+    /**
+     * Find the first occurrence of \p val among the first \p len characters of \p src, terminators included.
+     */
+    static inline const char *FindIn(const char *src, SizeType len, const char &val) {
+        return len ? static_cast<const char *>(::memchr(src, val, len)) : nullptr;
+    }
+
+    /**
+     * Find the last occurrence of \p val among the first \p len characters of \p src, terminators included.
+     */
+    static inline const char *ReverseFindIn(const char *src, SizeType len, const char &val) {
+        return Internal::ElementSearch<char, typename Internal::TypeTraitPatternSelector<char>::Type>::ReverseFind(
+                src, src + len, val);
     }
 
     // TODO: Find & ReverseFind Ignore Case
@@ -635,6 +673,15 @@ struct ICharTrait<wchar_t> {
         return ::wcslen(src);
     }
 
+    /**
+     * @param src null-terminated string
+     * @param count maximum amount of characters to examine.
+     * @return the length of the given string, or \p count if no terminator occurs in the first \p count characters
+     */
+    static inline SizeType Length(const wchar_t *src, SizeType count) {
+        return ::wcsnlen(src, count);
+    }
+
     /**
      * Compare between {left} string and {right} string.
      * @param left the first null-terminated string
@@ -658,34 +705,62 @@ struct ICharTrait<wchar_t> {
 
     /**
      * Compare between {left} string and {right} string,
-     * but ignore the case.
+     * but ignore the case of ASCII letters.
      * @param left the first null-terminated string
      * @param right the second null-terminated string
      * @return zero two strings are equal
-     * TODO: find a more efficient way!!!
      */
     static inline int CompareNoCase(const wchar_t *left, const wchar_t *right) {
         assert(left && right);
         if (left == right) {
             return 0;
         }
-        for (; *left && *right && tolower(*left) == tolower(*right); ++left, ++right);
-        return *left - *right;
+        return ICharTrait<wchar_t>::CompareNoCase(left, ICharTrait<wchar_t>::Length(left),
+                                                  right, ICharTrait<wchar_t>::Length(right));
     }
 
     /**
      * Compare the first \p count characters between {left} string and {right} string,
-     * but ignore the case.
+     * but ignore the case of ASCII letters.
      * @param left the first null-terminated string
      * @param right the second null-terminated string
      * @param count the maximum count of compared characters.
      * @return zero if the first {count} of characters of two strings are equal
-     * TODO: find a more efficient way!!!
      */
     static inline int CompareNoCase(const wchar_t *left, const wchar_t *right, SizeType count) {
         assert(left && right);
-        for (; *left && *right && tolower(*left) == tolower(*right) && count; ++left, ++right, --count);
-        return *left - *right;
+        return ICharTrait<wchar_t>::CompareNoCase(left, ICharTrait<wchar_t>::Length(left, count),
+                                                  right, ICharTrait<wchar_t>::Length(right, count));
+    }
+
+    /**
+     * Compare the first \p left_len characters of \p left with the first \p right_len characters of \p right,
+     * null characters included, but ignore the case of ASCII letters. Other characters are compared as they are,
+     * thus the result does not depend on the locale.
+     * @return zero if two ranges are equal
+     */
+    static inline int CompareNoCase(const wchar_t *left, SizeType left_len, const wchar_t *right, SizeType right_len) {
+        SizeType count = left_len < right_len ? left_len : right_len;
+        SizeType index = Internal::AsciiCase<wchar_t>::FoldedMismatch(left, right, count);
+        if (index < count) {
+            return Internal::CompareUnit(Internal::AsciiToLower(left[index]),
+                                         Internal::AsciiToLower(right[index]));
+        }
+        return left_len < right_len ? -1 : (left_len > right_len ? 1 : 0);
+    }
+
+    /**
+     * Convert the ASCII letters among the first \p count characters of \p src to lower case.
+     */
+    static inline void ToLower(wchar_t *src, SizeType count) {
+        Internal::AsciiCase<wchar_t>::ToLower(src, count);
+    }
+
+    /**
+     * Convert the ASCII letters among the first \p count characters of \p src to upper case.
+     */
+    static inline void ToUpper(wchar_t *src, SizeType count) {
+        Internal::AsciiCase<wchar_t>::ToUpper(src, count);
     }
 
     /**
@@ -737,18 +812,8 @@ struct ICharTrait<wchar_t> {
         if (!sub) {
             return nullptr;
         }
-        for (; *src && count; ++src, --count) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const wchar_t *src_ref = src, // prevent {src} from changing to ensure every char is scanned.
-                *sub_ref = sub; // also make a copy of {sub} to go back if it doesn't match.
-                SizeType count_ref = count;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref && count_ref; ++src_ref, ++sub_ref, --count_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    return src; // Thus, return it!
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return nullptr;
+        const wchar_t *end = src + ICharTrait<wchar_t>::Length(src, count);
+        return Searcher<wchar_t>(sub, ICharTrait<wchar_t>::Length(sub)).Find(src, end);
     }
 
     /**
@@ -790,18 +855,8 @@ struct ICharTrait<wchar_t> {
         if (!sub) {
             return nullptr;
         }
-        const wchar_t *last = nullptr;
-        for (; *src; ++src) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const wchar_t *src_ref = src,
-                        *sub_ref = sub;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref; ++src_ref, ++sub_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    last = src;
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
-        }
-        return last;
+        const wchar_t *end = src + ICharTrait<wchar_t>::Length(src);
+        return Searcher<wchar_t>(sub, ICharTrait<wchar_t>::Length(sub)).ReverseFind(src, end);
     }
 
     /**
@@ -816,19 +871,36 @@ struct ICharTrait<wchar_t> {
         if (!sub) {
             return nullptr;
         }
-        const wchar_t *last = nullptr;
-        for (; *src && count; ++src, --count) {
-            if (*src == *sub) { // the first char occurs, start to check
-                const wchar_t *src_ref = src,
-                        *sub_ref = sub;
-                SizeType count_ref = count;
-                for (; *src_ref && *sub_ref && *src_ref == *sub_ref && count_ref; ++src_ref, ++sub_ref, --count_ref);
-                if (!*sub_ref) { // finished scanning, and all char in sub matched.
-                    last = src;
-                } // Otherwise, src has terminated, or they do not match at all.
-            }
+        const wchar_t *end = src + ICharTrait<wchar_t>::Length(src, count);
+        return Searcher<wchar_t>(sub, ICharTrait<wchar_t>::Length(sub)).ReverseFind(src, end);
+    }
+
+    /**
+     * Compare the first \p left_len characters of \p left with the first \p right_len characters of \p right,
+     * null characters included. A range goes first if it is a prefix of the other.
+     * @return zero if two ranges are equal
+     */
+    static inline int Compare(const wchar_t *left, SizeType left_len, const wchar_t *right, SizeType right_len) {
+        SizeType count = left_len < right_len ? left_len : right_len;
+        if (int rtn = count ? ::wmemcmp(left, right, count) : 0) {
+            return rtn;
         }
-        return last;
+        return left_len < right_len ? -1 : (left_len > right_len ? 1 : 0);
+    }
+
+    /**
+     * Find the first occurrence of \p val among the first \p len characters of \p src, terminators included.
+     */
+    static inline const wchar_t *FindIn(const wchar_t *src, SizeType len, const wchar_t &val) {
+        return len ? ::wmemchr(src, val, len) : nullptr;
+    }
+
+    /**
+     * Find the last occurrence of \p val among the first \p len characters of \p src, terminators included.
+     */
+    static inline const wchar_t *ReverseFindIn(const wchar_t *src, SizeType len, const wchar_t &val) {
+        return Internal::ElementSearch<wchar_t, typename Internal::TypeTraitPatternSelector<wchar_t>::Type>::ReverseFind(
+                src, src + len, val);
     }
 
     // TODO: Find & ReverseFind Ignore Case
@@ -860,8 +932,219 @@ struct ICharTrait<wchar_t> {
     }
 };
 
+/**
+ * A non-owning view of a character sequence: its address and its length.
+ * The characters must outlive the view, and they need not be null-terminated.
+ * Views are cheap to copy, thus they are passed by value.
+ * @tparam Ch the type of characters
+ */
 template<typename Ch>
+class BasicStringView {
+public:
+    /**
+     * Creates an empty view.
+     */
+    BasicStringView() noexcept : first_(nullptr), len_(0) {}
+
+    /**
+     * Creates a view of the c-style null-terminated string \p str, without its terminator.
+     */
+    BasicStringView(const Ch *str) : first_(str), len_(str ? ICharTrait<Ch>::Length(str) : 0) {}
+
+    /**
+     * Creates a view of the first \p len characters starting at \p str.
+     */
+    BasicStringView(const Ch *str, SizeType len) noexcept : first_(str), len_(len) {}
+
+    SizeType Length() const noexcept {
+        return len_;
+    }
+
+    bool IsEmpty() const noexcept {
+        return !len_;
+    }
+
+    const Ch *ConstData() const noexcept {
+        return first_;
+    }
+
+    const Ch &ConstAt(SizeType index) const {
+        assert(index < len_);
+        return first_[index];
+    }
+
+    /**
+     * @param offset the index of the first character, clamped to the length
+     * @param count the maximum amount of characters, the rest of the view by default
+     * @return a view of at most \p count characters starting at \p offset, nothing is copied.
+     */
+    BasicStringView<Ch> Substring(SizeType offset, SizeType count = SizeType(-1)) const noexcept {
+        if (offset > len_) {
+            offset = len_;
+        }
+        if (count > len_ - offset) {
+            count = len_ - offset;
+        }
+        return BasicStringView<Ch>(first_ + offset, count);
+    }
+
+    int CompareTo(BasicStringView<Ch> other) const noexcept {
+        return ICharTrait<Ch>::Compare(first_, len_, other.first_, other.len_);
+    }
+
+    bool Equals(BasicStringView<Ch> other) const noexcept {
+        return len_ == other.len_ && !ICharTrait<Ch>::Compare(first_, len_, other.first_, other.len_);
+    }
+
+    /**
+     * @return a hash of the characters, equal views have equal hashes. It is not stable across processes.
+     */
+    SizeType Hash() const noexcept {
+        return SizeType(Internal::HashBytes(first_, len_ * sizeof(Ch)));
+    }
+
+    int CompareToNoCase(BasicStringView<Ch> other) const noexcept {
+        return ICharTrait<Ch>::CompareNoCase(first_, len_, other.first_, other.len_);
+    }
+
+    /**
+     * @return true if both views are equal, ignoring the case of ASCII letters
+     */
+    bool EqualsNoCase(BasicStringView<Ch> other) const noexcept {
+        return len_ == other.len_ && !ICharTrait<Ch>::CompareNoCase(first_, len_, other.first_, other.len_);
+    }
+
+    /**
+     * The locale-aware counterpart, which also folds non-ASCII letters, but one character at a time.
+     * @return true if both views are equal, ignoring the case by the \c std::ctype facet of \p locale
+     */
+    bool EqualsNoCase(BasicStringView<Ch> other, const std::locale &locale) const {
+        if (len_ != other.len_) {
+            return false;
+        }
+        const std::ctype<Ch> &ctype = std::use_facet<std::ctype<Ch>>(locale);
+        for (SizeType i = 0; i < len_; ++i) {
+            if (ctype.tolower(first_[i]) != ctype.tolower(other.first_[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    SizeType IndexOf(const Ch &ch) const {
+        return IndexOf(ch, 0, 1);
+    }
+
+    SizeType IndexOf(const Ch &ch, SizeType occurrence) const {
+        return IndexOf(ch, 0, occurrence);
+    }
+
+    /**
+     * @param offset the index to start searching from
+     * @param occurrence which occurrence to look for, counting from 1
+     * @return the index of the \p occurrence-th \p ch at or after \p offset, or -1 if not found
+     */
+    SizeType IndexOf(const Ch &ch, SizeType offset, SizeType occurrence) const {
+        if (!first_ || offset >= len_ || !occurrence) {
+            return -1;
+        }
+        for (const Ch *pos = first_ + offset, *end = first_ + len_;; ++pos) {
+            if (!(pos = ICharTrait<Ch>::FindIn(pos, end - pos, ch))) {
+                return -1;
+            }
+            if (!--occurrence) {
+                return pos - first_;
+            }
+        }
+    }
+
+    SizeType IndexOf(BasicStringView<Ch> sub) const {
+        return IndexOf(sub, 0, 1);
+    }
+
+    SizeType IndexOf(BasicStringView<Ch> sub, SizeType occurrence) const {
+        return IndexOf(sub, 0, occurrence);
+    }
+
+    /**
+     * Finds the \p occurrence-th non-overlapping \p sub at or after \p offset.
+     * Both sequences are bounded by their lengths, so null characters inside are matched like any other.
+     * @return the index of the occurrence, or -1 if not found
+     */
+    SizeType IndexOf(BasicStringView<Ch> sub, SizeType offset, SizeType occurrence) const {
+        if (!first_ || offset > len_ || !occurrence) {
+            return -1;
+        }
+        if (!sub.len_) {
+            offset += occurrence - 1;
+            return offset <= len_ ? offset : -1;
+        }
+        Searcher<Ch> searcher(sub.first_, sub.len_);
+        for (const Ch *pos = first_ + offset, *end = first_ + len_;; pos += sub.len_) {
+            if (!(pos = searcher.Find(pos, end))) {
+                return -1;
+            }
+            if (!--occurrence) {
+                return pos - first_;
+            }
+        }
+    }
+
+    /**
+     * Finds the needle of a prepared \p searcher, which can be reused across strings.
+     * @param offset the index to start searching from
+     * @return the index of the first occurrence at or after \p offset, or -1 if not found
+     */
+    SizeType IndexOf(const Searcher<Ch> &searcher, SizeType offset = 0) const {
+        if (!first_ || offset > len_) {
+            return -1;
+        }
+        if (const Ch *pos = searcher.Find(first_ + offset, first_ + len_)) {
+            return pos - first_;
+        }
+        return -1;
+    }
+
+    SizeType LastIndexOf(const Ch &ch) const {
+        if (const Ch *pos = first_ ? ICharTrait<Ch>::ReverseFindIn(first_, len_, ch) : nullptr) {
+            return pos - first_;
+        }
+        return -1;
+    }
+
+    SizeType LastIndexOf(BasicStringView<Ch> sub) const {
+        return LastIndexOf(Searcher<Ch>(sub.first_, sub.len_));
+    }
+
+    /**
+     * @return the index of the last occurrence of the needle of \p searcher, or -1 if not found
+     */
+    SizeType LastIndexOf(const Searcher<Ch> &searcher) const {
+        if (!first_) {
+            return -1;
+        }
+        if (const Ch *pos = searcher.ReverseFind(first_, first_ + len_)) {
+            return pos - first_;
+        }
+        return -1;
+    }
+
+private:
+    const Ch *first_;
+    SizeType len_;
+};
+
+template<typename Ch, typename Thread>
+class StringPool;
+
+/**
+ * @tparam Ch the type of characters
+ * @tparam Thread the thread policy of the shared block, see thread_policy.h
+ */
+template<typename Ch, typename Thread = MultiThreadPolicy>
 class BasicString {
+    friend class StringPool<Ch, Thread>;
+
 public:
     /**
      * Creates an empty instance
@@ -876,9 +1159,9 @@ public:
      * @param front_offset the amount of space remained before the first \p ch.
      * @param back_offset the amount of space remained after the last \p ch.
      */
-    BasicString(SizeType count, const Ch &ch, SizeType front_offset = 0, SizeType back_offset = 0) {
+    BasicString(SizeType count, const Ch &ch, SizeType front_offset = 0, SizeType back_offset = 0) : BasicString() {
         if (count) {
-            if (Ch *pos = BasicString<Ch>::SimpleAllocate(front_offset + count + back_offset, nullptr) + front_offset) {
+            if (Ch *pos = BasicString<Ch, Thread>::SimpleAllocate(front_offset + count + back_offset) + front_offset) {
                 ICharTrait<Ch>::Fill(pos, ch, count);
             }
         }
@@ -898,21 +1181,31 @@ public:
      * @param front_offset the amount of space remained before the \p str.
      * @param back_offset the amount of space remained after the \p str.
      */
-    BasicString(const Ch *str, SizeType len, SizeType front_offset = 0, SizeType back_offset = 0) {
+    BasicString(const Ch *str, SizeType len, SizeType front_offset = 0, SizeType back_offset = 0) : BasicString() {
         if (str && len) {
-            if (Ch *pos = BasicString<Ch>::SimpleAllocate(front_offset + len + back_offset, nullptr) + front_offset) {
+            if (Ch *pos = BasicString<Ch, Thread>::SimpleAllocate(front_offset + len + back_offset) + front_offset) {
                 ICharTrait<Ch>::Copy(pos, str, len);
             }
         }
     }
 
+    /**
+     * Creates an instance with a copy of the characters of \p view.
+     * This is explicit since it allocates, which views are meant to avoid.
+     * @param view the characters added to the instance
+     * @param front_offset the amount of space remained before the characters.
+     * @param back_offset the amount of space remained after the characters.
+     */
+    explicit BasicString(BasicStringView<Ch> view, SizeType front_offset = 0, SizeType back_offset = 0)
+            : BasicString(view.ConstData(), view.Length(), front_offset, back_offset) {}
+
     /**
      * COPY CONSTRUCTOR
      * Creates an instance with another instance.
      * If \p other is large enough, it will trigger sharing process.
      * @param other another instance
      */
-    BasicString(const BasicString<Ch> &other) : mode_(other.mode_) {
+    BasicString(const BasicString<Ch, Thread> &other) : mode_(other.mode_) {
         if (&other == this) {
             return; // don't do anything if the input is the current instance.
         }
@@ -923,16 +1216,14 @@ public:
          *  - 2. mode == Small: the small_ is valid, and we just need to directly copy all these things.
          *  - 3. mode == Allocate: the current instance will share with input instance (CODE BELOW).
          */
-        ::memcpy(this, &other, sizeof(BasicString<Ch>));
-        if (mode_ == Mode::Allocate) {
-            if (data_) { // prevent from violation.
-                if (*data_) { // the reference count has existed, then just need to add it.
-                    (**data_).IncrementRef();
-                } else { // otherwise, create a new one and initialize it to 2.
-                    *data_ = new RefCount(2);
-                }
+        ::memcpy(this, &other, sizeof(BasicString<Ch, Thread>));
+        if (mode_ == Mode::Allocate || mode_ == Mode::Slice) {
+            if (!Thread::kShareable) {
+                new(this)BasicString<Ch, Thread>(other.first_, other.last_ - other.first_);
+            } else if (data_) { // prevent from violation.
+                BasicString<Ch, Thread>::Share(); // the count lives in the block, sharing never allocates.
             } else {
-                new(this)BasicString<Ch>();
+                new(this)BasicString<Ch, Thread>();
             }
         }
     }
@@ -945,10 +1236,10 @@ public:
      * @param front_offset
      * @param back_offset
      */
-    BasicString(const BasicString<Ch> &other, SizeType offset, SizeType count,
+    BasicString(const BasicString<Ch, Thread> &other, SizeType offset, SizeType count,
                 SizeType front_offset = 0, SizeType back_offset = 0) {
         assert(count < other.last_ - other.first_ - offset);
-        new(this)BasicString<Ch>(other.first_ + offset, count, front_offset, back_offset);
+        new(this)BasicString<Ch, Thread>(other.first_ + offset, count, front_offset, back_offset);
     }
 
     /**
@@ -956,15 +1247,12 @@ public:
      * Releases all unnecessary data if they are not sharing with other instances.
      */
     ~BasicString() {
-        if (mode_ == Mode::Allocate) {
+        if (mode_ == Mode::Allocate || mode_ == Mode::Slice) {
             if (data_) {
-                if (*data_ && (**data_).Value() > 1) {
-                    (**data_).DecrementRef();
+                if (data_->Value() > 1 && !data_->ReleaseRef()) { // sharing, decrease and quit.
                     return;
-                } else {
-                    delete *data_;
                 }
-                ::free((void *) data_);
+                BasicString<Ch, Thread>::SimpleFree();
             }
         }
     }
@@ -1014,17 +1302,20 @@ public:
      * @param capacity the amount of characters required.
      * @return the current instance
      */
-    BasicString<Ch> &EnsureCapacity(const SizeType &capacity) {
+    BasicString<Ch, Thread> &EnsureCapacity(const SizeType &capacity) {
+        if (mode_ == Mode::Slice) {
+            BasicString<Ch, Thread>::Detach();
+        }
         if (mode_ == Mode::Null) { // if the current mode is null,
             if (capacity) { // and the capacity is nonzero, then allocate memory for intended capacity.
-                SimpleAllocate(SmallLength(), capacity, nullptr);
+                SimpleAllocate(0, capacity);
             }
         } else if (mode_ == Mode::Small) { // if the current mode is small,
             if (capacity >= kSmallCap) { // and the intended capacity is larger than stack can store,
                 SizeType len(SmallLength()); // change the mode to Allocate with intended capacity.
                 Ch old[kSmallCap];
                 ICharTrait<Ch>::Copy(old, small_, len);
-                if (Ch *pos = SimpleAllocate(len, capacity, nullptr)) {
+                if (Ch *pos = SimpleAllocate(len, capacity)) {
                     ICharTrait<Ch>::Copy(pos, old, len);
                 }
             }
@@ -1032,21 +1323,14 @@ public:
             if (data_) {
                 SizeType old_len = last_ - first_;
                 if (capacity > end_ - first_) { // if the capacity is smaller than intended capacity,
-                    if (*data_ && (**data_).Value() > 1) { // if the instance is sharing,
-                        (**data_).DecrementRef(); // then detach and allocate (temporarily) independent data.
+                    if (data_->Value() > 1) { // if the instance is sharing,
+                        data_->DecrementRef(); // then detach and allocate (temporarily) independent data.
                         Ch *old = first_;
-                        if (Ch *pos = SimpleAllocate(old_len, capacity, nullptr)) {
+                        if (Ch *pos = SimpleAllocate(old_len, capacity)) {
                             ICharTrait<Ch>::Copy(pos, old, old_len);
                         }
                     } else { // otherwise, enlarge it by simply call realloc
-                        RefCount **old_data = data_;
-                        SizeType len = last_ - first_;
-                        data_ = static_cast<RefCount **>(::realloc(data_, TotCap(capacity)));
-                        if (old_data != data_) { // if the data moves, then reassign other member variables.
-                            first_ = (Ch *) (data_ + 1);
-                            last_ = first_ + len;
-                        }
-                        end_ = first_ + capacity; // this must be done even we do not move the memory.
+                        SimpleReallocate(old_len, capacity);
                     }
                 }
             }
@@ -1055,6 +1339,9 @@ public:
     }
 
     Ch &At(SizeType index) {
+        if (mode_ == Mode::Slice) {
+            BasicString<Ch, Thread>::Detach();
+        }
         if (mode_ == Mode::Small) {
             assert(index < kSmallLen);
             return small_[index];
@@ -1062,25 +1349,24 @@ public:
             assert(data_);
             SizeType len = last_ - first_;
             assert(index < len);
-            if ((*data_) && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
-                Ch *old = first_;
-                if (Ch *pos = SimpleAllocate(len, nullptr)) {
-                    ICharTrait<Ch>::Copy(pos, old, len);
-                }
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
+                Ch *old = first_, *pos = SimpleAllocate(len); // may be the small buffer now.
+                ICharTrait<Ch>::Copy(pos, old, len);
+                return pos[index];
             }
-            return first_ + index;
+            return first_[index];
         }
         assert(false);
     }
 
     const Ch &ConstAt(SizeType index) {
-        if (mode_ == small_) {
+        if (mode_ == Mode::Small) {
             assert(index < SmallLength());
             return small_[index];
-        } else if (mode_ == Mode::Allocate) {
+        } else if (mode_ == Mode::Allocate || mode_ == Mode::Slice) {
             assert(data_ && index < last_ - first_);
-            return first_ + index;
+            return first_[index];
         }
         assert(false);
     }
@@ -1089,18 +1375,20 @@ public:
      * @return the address of contiguous memory of the string, mutable
      */
     Ch *Data() {
+        if (mode_ == Mode::Slice) {
+            BasicString<Ch, Thread>::Detach();
+        }
         if (mode_ == Mode::Null) {
             return nullptr;
         } else if (mode_ == Mode::Small) {
             return small_;
         } else if (data_) {
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
                 SizeType len = last_ - first_;
-                Ch *old = first_, *pos = SimpleAllocate(len, nullptr);
-                if (pos) {
-                    ICharTrait<Ch>::Copy(pos, first_, len);
-                }
+                Ch *old = first_, *pos = SimpleAllocate(len); // may be the small buffer now.
+                ICharTrait<Ch>::Copy(pos, old, len);
+                return pos;
             }
             return first_;
         }
@@ -1121,128 +1409,235 @@ public:
         return nullptr;
     }
 
+    /**
+     * Creates a substring of at most \p len characters starting at \p offset.
+     * A substring of a heap-allocated instance shares its block instead of copying the characters,
+     * thus slicing a large string into fields is cheap. Either one copies only when it is modified.
+     * Short substrings are copied into the small buffer, so that they do not keep a large block alive.
+     * @note The characters of a shared substring are not null-terminated, Data() gives terminated ones.
+     * @param offset the index of the first character, clamped to the length
+     * @param len the maximum amount of characters, the rest of the string by default
+     */
+    BasicString<Ch, Thread> Substring(SizeType offset, SizeType len = SizeType(-1)) const {
+        BasicStringView<Ch> view(BasicStringView<Ch>(*this).Substring(offset, len));
+        if (view.Length() == Length()) {
+            return *this;
+        }
+        if (mode_ == Mode::Small || !Thread::kShareable || view.Length() <= kSmallLen) {
+            return BasicString<Ch, Thread>(view);
+        }
+        BasicString<Ch, Thread> rtn;
+        rtn.mode_ = Mode::Slice;
+        rtn.data_ = data_;
+        rtn.first_ = const_cast<Ch *>(view.ConstData());
+        rtn.last_ = rtn.end_ = rtn.first_ + view.Length();
+        BasicString<Ch, Thread>::Share();
+        return rtn;
+    }
+
+    /**
+     * @return a view of the characters, which is valid until the next modification of the instance
+     */
+    operator BasicStringView<Ch>() const noexcept {
+        return BasicStringView<Ch>(ConstData(), Length());
+    }
+
     int CompareTo(const Ch *other) const noexcept {
-        return ICharTrait<Ch>::Compare(ConstData(), other);
+        return BasicStringView<Ch>(*this).CompareTo(other);
     }
 
-    int CompareTo(const BasicString<Ch> &other) const noexcept {
-        return ICharTrait<Ch>::Compare(ConstData(), other.ConstData());
+    int CompareTo(const BasicString<Ch, Thread> &other) const noexcept {
+        return BasicStringView<Ch>(*this).CompareTo(other);
     }
 
-    int CompareToNoCase(const Ch *other) const noexcept {
-        return ICharTrait<Ch>::CompareNoCase(ConstData(), other);
+    int CompareTo(BasicStringView<Ch> other) const noexcept {
+        return BasicStringView<Ch>(*this).CompareTo(other);
     }
 
-    int CompareToNoCase(const BasicString<Ch> &other) const noexcept {
-        return ICharTrait<Ch>::CompareNoCase(ConstData(), other.ConstData());
+    bool Equals(BasicStringView<Ch> other) const noexcept {
+        return BasicStringView<Ch>(*this).Equals(other);
     }
 
-    SizeType IndexOf(const Ch &ch) {
-        const Ch *str(ConstData());
-        if (const Ch *pos = ICharTrait<Ch>::Find(str, ch)) {
-            return pos - str;
+    /**
+     * Hashes the characters, the same way as BasicStringView does.
+     * A shared heap block caches its hash next to the reference count, thus hashing
+     * the same interned key again is O(1). Unshared blocks may still be modified in place,
+     * so their hash is computed every time, and a slot left over from an earlier sharing is ignored.
+     * @return a hash of the characters, equal strings have equal hashes
+     */
+    SizeType Hash() const noexcept {
+        if (mode_ != Mode::Allocate || !data_ || data_->Value() <= 1) {
+            return BasicStringView<Ch>(*this).Hash();
         }
-        return -1;
+        HashSlot *slot = BasicString<Ch, Thread>::CachedHash();
+        SizeType rtn = slot->load(std::memory_order_relaxed);
+        if (!rtn) {
+            rtn = BasicStringView<Ch>(*this).Hash();
+            slot->store(rtn, std::memory_order_relaxed); // 0 stays uncached, which is harmless.
+        }
+        return rtn;
     }
 
-    SizeType IndexOf(const Ch &ch, SizeType occurrence) {
-        const Ch *str(ConstData()), *curr(ICharTrait<Ch>::Find(str, ch)), *prev(nullptr);
-        if (str) {
-            for (; occurrence && curr; --occurrence) {
-                prev = curr;
-                curr = ICharTrait<Ch>::Find(prev + 1, ch);
-            }
-        }
-        return occurrence ? -1 : prev - str;
+    int CompareToNoCase(const Ch *other) const noexcept {
+        return BasicStringView<Ch>(*this).CompareToNoCase(other);
+    }
+
+    int CompareToNoCase(const BasicString<Ch, Thread> &other) const noexcept {
+        return BasicStringView<Ch>(*this).CompareToNoCase(other);
+    }
+
+    int CompareToNoCase(BasicStringView<Ch> other) const noexcept {
+        return BasicStringView<Ch>(*this).CompareToNoCase(other);
+    }
+
+    /**
+     * @return true if both strings are equal, ignoring the case of ASCII letters
+     */
+    bool EqualsNoCase(BasicStringView<Ch> other) const noexcept {
+        return BasicStringView<Ch>(*this).EqualsNoCase(other);
+    }
+
+    /**
+     * @return true if both strings are equal, ignoring the case by the \c std::ctype facet of \p locale
+     */
+    bool EqualsNoCase(BasicStringView<Ch> other, const std::locale &locale) const {
+        return BasicStringView<Ch>(*this).EqualsNoCase(other, locale);
     }
 
-    SizeType IndexOf(const Ch &ch, SizeType offset, SizeType occurrence) {
+    /**
+     * Converts the ASCII letters to lower case, in place.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &ToLower() {
         SizeType len(Length());
-        const Ch *str(ConstData());
-        if (!str || offset >= len) {
-            return -1;
-        }
-        str += offset;
-        const Ch *curr(ICharTrait<Ch>::Find(str, ch)), *prev(nullptr);
-        for (; occurrence && curr; --occurrence) {
-            prev = curr;
-            curr = ICharTrait<Ch>::Find(prev + 1, ch);
+        if (Ch *str = Data()) {
+            ICharTrait<Ch>::ToLower(str, len);
         }
-        return occurrence ? -1 : prev - str + offset;
+        return *this;
     }
 
-    SizeType IndexOf(const Ch *sub) {
-        const Ch *str(ConstData());
-        if (const Ch *pos = ICharTrait<Ch>::Find(str, sub)) {
-            return pos - str;
+    /**
+     * Converts the letters to lower case by the \c std::ctype facet of \p locale, in place.
+     * Unlike ToLower(), it also maps non-ASCII letters, but one character at a time.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &ToLower(const std::locale &locale) {
+        SizeType len(Length());
+        if (Ch *str = Data()) {
+            std::use_facet<std::ctype<Ch>>(locale).tolower(str, str + len);
         }
-        return -1;
+        return *this;
     }
 
-    SizeType IndexOf(const Ch *sub, SizeType occurrence) {
-        SizeType sub_len(ICharTrait<Ch>::Length(sub));
-        const Ch *str(ConstData()), *curr(ICharTrait<Ch>::Find(str, sub)), *prev(nullptr);
-        if (str && sub_len && sub) {
-            for (; occurrence && curr; --occurrence) {
-                prev = curr;
-                curr = ICharTrait<Ch>::Find(prev + sub_len, sub);
-            }
+    /**
+     * Converts the ASCII letters to upper case, in place.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &ToUpper() {
+        SizeType len(Length());
+        if (Ch *str = Data()) {
+            ICharTrait<Ch>::ToUpper(str, len);
         }
-        return occurrence ? -1 : prev - str;
+        return *this;
     }
 
-    SizeType IndexOf(const Ch *sub, SizeType offset, SizeType occurrence) {
-        SizeType len(Length()), sub_len(ICharTrait<Ch>::Length(sub));
-        const Ch *str(ConstData());
-        if (!str || !sub_len || offset >= len - sub_len) {
-            return -1;
-        }
-        str += offset;
-        const Ch *curr(ICharTrait<Ch>::Find(str, sub)), *prev(nullptr);
-        for (; occurrence && curr; --occurrence) {
-            prev = curr;
-            curr = ICharTrait<Ch>::Find(prev + sub_len, str);
+    /**
+     * Converts the letters to upper case by the \c std::ctype facet of \p locale, in place.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &ToUpper(const std::locale &locale) {
+        SizeType len(Length());
+        if (Ch *str = Data()) {
+            std::use_facet<std::ctype<Ch>>(locale).toupper(str, str + len);
         }
-        return occurrence ? -1 : prev - str + offset;
+        return *this;
     }
 
-    SizeType IndexOf(const BasicString<Ch> &other) {
-        return IndexOf(other.ConstData());
+    SizeType IndexOf(const Ch &ch) const {
+        return BasicStringView<Ch>(*this).IndexOf(ch, 0, 1);
     }
 
-    SizeType IndexOf(const BasicString<Ch> &other, SizeType occurrence) {
-        return IndexOf(other.ConstData(), occurrence);
+    SizeType IndexOf(const Ch &ch, SizeType occurrence) const {
+        return BasicStringView<Ch>(*this).IndexOf(ch, 0, occurrence);
     }
 
-    SizeType IndexOf(const BasicString<Ch> &other, SizeType offset, SizeType occurrence) {
-        return IndexOf(other.ConstData(), offset, occurrence);
+    SizeType IndexOf(const Ch &ch, SizeType offset, SizeType occurrence) const {
+        return BasicStringView<Ch>(*this).IndexOf(ch, offset, occurrence);
     }
 
-    SizeType LastIndexOf(const Ch &ch) {
-        const Ch *str(ConstData());
-        if (const Ch *pos = ICharTrait<Ch>::ReverseFind(str, ch)) {
-            return pos - str;
-        }
-        return -1;
+    SizeType IndexOf(const Ch *sub) const {
+        return IndexOf(sub, 0, 1);
     }
 
-    SizeType LastIndexOf(const Ch *&sub) {
-        const Ch *str(ConstData());
-        if (const Ch *pos = ICharTrait<Ch>::ReverseFind(str, sub)) {
-            return pos - str;
-        }
-        return -1;
+    SizeType IndexOf(const Ch *sub, SizeType occurrence) const {
+        return IndexOf(sub, 0, occurrence);
+    }
+
+    SizeType IndexOf(const Ch *sub, SizeType offset, SizeType occurrence) const {
+        return sub ? BasicStringView<Ch>(*this).IndexOf(BasicStringView<Ch>(sub), offset, occurrence) : -1;
+    }
+
+    SizeType IndexOf(const BasicString<Ch, Thread> &other) const {
+        return BasicStringView<Ch>(*this).IndexOf(BasicStringView<Ch>(other), 0, 1);
+    }
+
+    SizeType IndexOf(const BasicString<Ch, Thread> &other, SizeType occurrence) const {
+        return BasicStringView<Ch>(*this).IndexOf(BasicStringView<Ch>(other), 0, occurrence);
+    }
+
+    SizeType IndexOf(const BasicString<Ch, Thread> &other, SizeType offset, SizeType occurrence) const {
+        return BasicStringView<Ch>(*this).IndexOf(BasicStringView<Ch>(other), offset, occurrence);
+    }
+
+    SizeType IndexOf(BasicStringView<Ch> sub) const {
+        return BasicStringView<Ch>(*this).IndexOf(sub, 0, 1);
+    }
+
+    SizeType IndexOf(BasicStringView<Ch> sub, SizeType occurrence) const {
+        return BasicStringView<Ch>(*this).IndexOf(sub, 0, occurrence);
+    }
+
+    SizeType IndexOf(BasicStringView<Ch> sub, SizeType offset, SizeType occurrence) const {
+        return BasicStringView<Ch>(*this).IndexOf(sub, offset, occurrence);
+    }
+
+    /**
+     * Finds the needle of a prepared \p searcher, which can be reused across strings.
+     * @param offset the index to start searching from
+     * @return the index of the first occurrence at or after \p offset, or -1 if not found
+     */
+    SizeType IndexOf(const Searcher<Ch> &searcher, SizeType offset = 0) const {
+        return BasicStringView<Ch>(*this).IndexOf(searcher, offset);
+    }
+
+    SizeType LastIndexOf(const Ch &ch) const {
+        return BasicStringView<Ch>(*this).LastIndexOf(ch);
+    }
+
+    SizeType LastIndexOf(const Ch *sub) const {
+        return sub ? BasicStringView<Ch>(*this).LastIndexOf(BasicStringView<Ch>(sub)) : -1;
+    }
+
+    SizeType LastIndexOf(const BasicString<Ch, Thread> &other) const {
+        return BasicStringView<Ch>(*this).LastIndexOf(BasicStringView<Ch>(other));
+    }
+
+    SizeType LastIndexOf(BasicStringView<Ch> sub) const {
+        return BasicStringView<Ch>(*this).LastIndexOf(sub);
     }
 
-    SizeType LastIndexOf(const BasicString<Ch> &other) {
-        return LastIndexOf(other.ConstData());
+    /**
+     * @return the index of the last occurrence of the needle of \p searcher, or -1 if not found
+     */
+    SizeType LastIndexOf(const Searcher<Ch> &searcher) const {
+        return BasicStringView<Ch>(*this).LastIndexOf(searcher);
     }
 
-    BasicString<Ch> &Assign(const Ch *str) {
+    BasicString<Ch, Thread> &Assign(const Ch *str) {
         return Assign(str, ICharTrait<Ch>::Length(str), 0, 0);
     }
 
-    BasicString<Ch> &Assign(const Ch *str, SizeType len,
+    BasicString<Ch, Thread> &Assign(const Ch *str, SizeType len,
                             SizeType front_offset = 0, SizeType back_offset = 0) {
         if (str && len) {
             if (Ch *pos = AssignImpl(front_offset + len + back_offset) + front_offset) {
@@ -1252,20 +1647,35 @@ public:
         return *this;
     }
 
-    BasicString<Ch> &Assign(const BasicString<Ch> &other) {
-        if (mode_ == Mode::Allocate) {
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
-            } else {
-                delete *data_;
-                ::free(data_);
-            }
+    /**
+     * Replaces the content of the instance with the characters of \p view.
+     * \p view may refer to this instance.
+     * @param view the additional characters
+     * @param front_offset the amount of space remained before the characters.
+     * @param back_offset the amount of space remained after the characters.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &Assign(BasicStringView<Ch> view, SizeType front_offset = 0, SizeType back_offset = 0) {
+        if (BasicString<Ch, Thread>::Overlaps(view)) {
+            BasicString<Ch, Thread> copy(view);
+            return Assign(copy.ConstData(), copy.Length(), front_offset, back_offset);
+        }
+        return Assign(view.ConstData(), view.Length(), front_offset, back_offset);
+    }
+
+    BasicString<Ch, Thread> &Assign(const BasicString<Ch, Thread> &other) {
+        if (&other == this) {
+            return *this;
         }
-        new(this)BasicString<Ch>(other);
+        if ((mode_ == Mode::Allocate || mode_ == Mode::Slice) && data_ &&
+            (data_->Value() == 1 || data_->ReleaseRef())) {
+            BasicString<Ch, Thread>::SimpleFree();
+        }
+        new(this)BasicString<Ch, Thread>(other);
         return *this;
     }
 
-    BasicString<Ch> &Assign(const BasicString<Ch> &other, SizeType offset, SizeType len,
+    BasicString<Ch, Thread> &Assign(const BasicString<Ch, Thread> &other, SizeType offset, SizeType len,
                             SizeType front_offset = 0, SizeType back_offset = 0) {
         SizeType total(other.Length());
         if (offset + len > total) {
@@ -1288,7 +1698,7 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Append(const Ch &ch, SizeType count = 1, SizeType front_offset = 0, SizeType back_offset = 0) {
+    BasicString<Ch, Thread> &Append(const Ch &ch, SizeType count = 1, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (ch && count) {
             if (Ch *pos = GrowthAppend(front_offset + count + back_offset) + front_offset) {
                 ICharTrait<Ch>::Fill(pos, ch, count);
@@ -1305,8 +1715,8 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Append(const Ch *str, SizeType front_offset = 0, SizeType back_offset = 0) {
-        return BasicString<Ch>::Append(str, ICharTrait<Ch>::Length(str), front_offset, back_offset);
+    BasicString<Ch, Thread> &Append(const Ch *str, SizeType front_offset = 0, SizeType back_offset = 0) {
+        return BasicString<Ch, Thread>::Append(str, ICharTrait<Ch>::Length(str), front_offset, back_offset);
     }
 
     /**
@@ -1318,7 +1728,7 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Append(const Ch *str, SizeType len, SizeType front_offset = 0, SizeType back_offset = 0) {
+    BasicString<Ch, Thread> &Append(const Ch *str, SizeType len, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (str && len) {
             if (Ch *pos = GrowthAppend(front_offset + len + back_offset) + front_offset) {
                 ICharTrait<Ch>::Copy(pos, str, len);
@@ -1327,24 +1737,40 @@ public:
         return *this;
     }
 
-    BasicString<Ch> &Append(const BasicString<Ch> &other, SizeType front_offset = 0, SizeType back_offset = 0) {
+    /**
+     * Extends the string by putting the characters of \p view at the end of the instance.
+     * \p view may refer to this instance.
+     * @param view the additional characters
+     * @param front_offset the amount of space remained before the characters.
+     * @param back_offset the amount of space remained after the characters.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &Append(BasicStringView<Ch> view, SizeType front_offset = 0, SizeType back_offset = 0) {
+        if (BasicString<Ch, Thread>::Overlaps(view)) {
+            BasicString<Ch, Thread> copy(view);
+            return Append(copy.ConstData(), copy.Length(), front_offset, back_offset);
+        }
+        return Append(view.ConstData(), view.Length(), front_offset, back_offset);
+    }
+
+    BasicString<Ch, Thread> &Append(const BasicString<Ch, Thread> &other, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (data_ || front_offset || back_offset) {
             if (other.mode_ == Mode::Small) {
                 return Append(other.small_, other.SmallLength(), front_offset, back_offset);
-            } else if (other.mode_ == Mode::Allocate) {
-                return Append(other.first_, other.last_ - first_, front_offset, back_offset);
+            } else if (other.mode_ == Mode::Allocate || other.mode_ == Mode::Slice) {
+                return Append(other.first_, other.last_ - other.first_, front_offset, back_offset);
             }
         } else {
-            new(this)BasicString<Ch>(other);
+            new(this)BasicString<Ch, Thread>(other);
         }
         return *this;
     }
 
-    BasicString<Ch> &Append(const BasicString<Ch> &other, SizeType offset, SizeType len,
+    BasicString<Ch, Thread> &Append(const BasicString<Ch, Thread> &other, SizeType offset, SizeType len,
                             SizeType front_offset = 0, SizeType back_offset = 0) {
         if (other.mode_ == Mode::Small) {
             return Append(other.small_ + offset, len, front_offset, back_offset);
-        } else if (other.mode_ == Mode::Allocate) {
+        } else if (other.mode_ == Mode::Allocate || other.mode_ == Mode::Slice) {
             return Append(other.first_ + offset, len, front_offset, back_offset);
         }
         return *this;
@@ -1359,7 +1785,7 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Prepend(const Ch &ch, SizeType count = 1, SizeType front_offset = 0, SizeType back_offset = 0) {
+    BasicString<Ch, Thread> &Prepend(const Ch &ch, SizeType count = 1, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (ch && count) {
             if (Ch *pos = GrowthPrepend(front_offset + count + back_offset) + front_offset) {
                 ICharTrait<Ch>::Fill(pos, ch, count);
@@ -1376,8 +1802,8 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Prepend(const Ch *str, SizeType front_offset = 0, SizeType back_offset = 0) {
-        return BasicString<Ch>::Prepend(str, ICharTrait<Ch>::Length(str), front_offset, back_offset);
+    BasicString<Ch, Thread> &Prepend(const Ch *str, SizeType front_offset = 0, SizeType back_offset = 0) {
+        return BasicString<Ch, Thread>::Prepend(str, ICharTrait<Ch>::Length(str), front_offset, back_offset);
     }
 
     /**
@@ -1389,7 +1815,7 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Prepend(const Ch *str, SizeType len, SizeType front_offset = 0, SizeType back_offset = 0) {
+    BasicString<Ch, Thread> &Prepend(const Ch *str, SizeType len, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (str && len) {
             if (Ch *pos = GrowthPrepend(front_offset + len + back_offset) + front_offset) {
                 ICharTrait<Ch>::Copy(pos, str, len);
@@ -1398,24 +1824,40 @@ public:
         return *this;
     }
 
-    BasicString<Ch> &Prepend(const BasicString<Ch> &other, SizeType front_offset = 0, SizeType back_offset = 0) {
+    /**
+     * Extends the string by putting the characters of \p view at the front of the instance.
+     * \p view may refer to this instance.
+     * @param view the additional characters
+     * @param front_offset the amount of space remained before the characters.
+     * @param back_offset the amount of space remained after the characters.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &Prepend(BasicStringView<Ch> view, SizeType front_offset = 0, SizeType back_offset = 0) {
+        if (BasicString<Ch, Thread>::Overlaps(view)) {
+            BasicString<Ch, Thread> copy(view);
+            return Prepend(copy.ConstData(), copy.Length(), front_offset, back_offset);
+        }
+        return Prepend(view.ConstData(), view.Length(), front_offset, back_offset);
+    }
+
+    BasicString<Ch, Thread> &Prepend(const BasicString<Ch, Thread> &other, SizeType front_offset = 0, SizeType back_offset = 0) {
         if (data_ || front_offset || back_offset) {
             if (other.mode_ == Mode::Small) {
                 return Prepend(other.small_, other.SmallLength(), front_offset, back_offset);
-            } else if (other.mode_ == Mode::Allocate) {
-                return Prepend(other.first_, other.last_ - first_, front_offset, back_offset);
+            } else if (other.mode_ == Mode::Allocate || other.mode_ == Mode::Slice) {
+                return Prepend(other.first_, other.last_ - other.first_, front_offset, back_offset);
             }
         } else {
-            new(this)BasicString<Ch>(other);
+            new(this)BasicString<Ch, Thread>(other);
         }
         return *this;
     }
 
-    BasicString<Ch> &Prepend(const BasicString<Ch> &other, SizeType offset, SizeType len,
+    BasicString<Ch, Thread> &Prepend(const BasicString<Ch, Thread> &other, SizeType offset, SizeType len,
                              SizeType front_offset = 0, SizeType back_offset = 0) {
         if (other.mode_ == Mode::Small) {
             return Prepend(other.small_ + offset, len, front_offset, back_offset);
-        } else if (other.mode_ == Mode::Allocate) {
+        } else if (other.mode_ == Mode::Allocate || other.mode_ == Mode::Slice) {
             return Prepend(other.first_ + offset, len, front_offset, back_offset);
         }
         return *this;
@@ -1431,7 +1873,7 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Insert(SizeType index, const Ch &ch, SizeType count = 1,
+    BasicString<Ch, Thread> &Insert(SizeType index, const Ch &ch, SizeType count = 1,
                             SizeType front_offset = 0, SizeType back_offset = 0) {
         if (ch && count) {
             if (Ch *pos = GrowthInsert(index, front_offset + count + back_offset) + front_offset) {
@@ -1450,8 +1892,8 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Insert(SizeType index, const Ch *str, SizeType front_offset = 0, SizeType back_offset = 0) {
-        return BasicString<Ch>::Insert(index, str, ICharTrait<Ch>::Length(str), front_offset, back_offset);
+    BasicString<Ch, Thread> &Insert(SizeType index, const Ch *str, SizeType front_offset = 0, SizeType back_offset = 0) {
+        return BasicString<Ch, Thread>::Insert(index, str, ICharTrait<Ch>::Length(str), front_offset, back_offset);
     }
 
     /**
@@ -1464,7 +1906,7 @@ public:
      * @param back_offset the amount of space remained after the \p str.
      * @return the current instance
      */
-    BasicString<Ch> &Insert(SizeType index, const Ch *str, SizeType len,
+    BasicString<Ch, Thread> &Insert(SizeType index, const Ch *str, SizeType len,
                             SizeType front_offset = 0, SizeType back_offset = 0) {
         if (str && len) {
             if (Ch *pos = GrowthInsert(index, front_offset + len + back_offset) + front_offset) {
@@ -1474,41 +1916,61 @@ public:
         return *this;
     }
 
-    BasicString<Ch> &Insert(SizeType index, const BasicString<Ch> &other,
+    /**
+     * Extends the string by putting the characters of \p view at the \p index position of the instance.
+     * \p view may refer to this instance.
+     * @param view the additional characters
+     * @param front_offset the amount of space remained before the characters.
+     * @param back_offset the amount of space remained after the characters.
+     * @return the current instance
+     */
+    BasicString<Ch, Thread> &Insert(SizeType index, BasicStringView<Ch> view,
+                            SizeType front_offset = 0, SizeType back_offset = 0) {
+        if (BasicString<Ch, Thread>::Overlaps(view)) {
+            BasicString<Ch, Thread> copy(view);
+            return Insert(index, copy.ConstData(), copy.Length(), front_offset, back_offset);
+        }
+        return Insert(index, view.ConstData(), view.Length(), front_offset, back_offset);
+    }
+
+    BasicString<Ch, Thread> &Insert(SizeType index, const BasicString<Ch, Thread> &other,
                             SizeType front_offset = 0, SizeType back_offset = 0) {
         if (data_ || front_offset || back_offset) {
             if (other.mode_ == Mode::Small) {
                 return Insert(index, other.small_, other.SmallLength(), front_offset, back_offset);
-            } else if (other.mode_ == Mode::Allocate) {
-                return Insert(index, other.first_, other.last_ - first_, front_offset, back_offset);
+            } else if (other.mode_ == Mode::Allocate || other.mode_ == Mode::Slice) {
+                return Insert(index, other.first_, other.last_ - other.first_, front_offset, back_offset);
             }
         } else {
-            new(this)BasicString<Ch>(other);
+            new(this)BasicString<Ch, Thread>(other);
         }
         return *this;
     }
 
-    BasicString<Ch> &Insert(SizeType index, const BasicString<Ch> &other, SizeType offset, SizeType len,
+    BasicString<Ch, Thread> &Insert(SizeType index, const BasicString<Ch, Thread> &other, SizeType offset, SizeType len,
                             SizeType front_offset = 0, SizeType back_offset = 0) {
         if (other.mode_ == Mode::Small) {
             return Insert(index, other.small_ + offset, len, front_offset, back_offset);
-        } else if (other.mode_ == Mode::Allocate) {
+        } else if (other.mode_ == Mode::Allocate || other.mode_ == Mode::Slice) {
             return Insert(index, other.first_ + offset, len, front_offset, back_offset);
         }
         return *this;
     }
 
-    BasicString<Ch> &Remove(SizeType index, SizeType count) {
+    BasicString<Ch, Thread> &Remove(SizeType index, SizeType count) {
+        if (mode_ == Mode::Slice) {
+            BasicString<Ch, Thread>::Detach();
+        }
         if (mode_ == Mode::Small) {
             SizeType old_len(SmallLength()), new_len(old_len - count);
-            ICharTrait<Ch>::Move(small_ + index + count, small_ + index, old_len - index - count);
+            ICharTrait<Ch>::Move(small_ + index, small_ + index + count, old_len - index - count);
             SetSmallLength(new_len, true);
         } else if (mode_ == Mode::Allocate) {
             if (data_) {
-                if (*data_ && (**data_).Value() > 1) {
-                    (**data_).DecrementRef();
+                if (data_->Value() > 1) {
+                    data_->DecrementRef();
                     SizeType old_len(last_ - first_), new_len(old_len - count);
-                    Ch *old_str = first_, *new_str(SimpleAllocate(new_len, nullptr));
+                    Ch *old_str = first_, *new_str(SimpleAllocate(new_len));
                     if (new_str) {
                         ICharTrait<Ch>::Copy(new_str, old_str, index);
                         ICharTrait<Ch>::Copy(new_str + index, old_str + index + count, old_len - index - count);
@@ -1516,6 +1978,7 @@ public:
                 } else {
                     ICharTrait<Ch>::Move(first_ + index, first_ + index + count, last_ - first_ - index - count);
                     last_ -= count;
+                    *last_ = Ch(0);
                 }
             }
         }
@@ -1531,13 +1994,17 @@ private:
         Small,
 
         // The string stores the char sequence in the heap.
-        Allocate
+        Allocate,
+
+        // The string shares a range of the heap block of another instance, see Substring.
+        // The range is not null-terminated, and the instance owns a copy once it is modified.
+        Slice
     };
 
-    using RefCount = Internal::ReferenceCount;
+    using RefCount = typename Thread::RefCount;
 
     struct GeneralBuffer {
-        RefCount **ref_;
+        RefCount *ref_;
         Ch *first_;
         Ch *last_;
         Ch *end_;
@@ -1548,7 +2015,7 @@ private:
         unsigned char bytes_[sizeof(GeneralBuffer)];
         Ch small_[sizeof(GeneralBuffer) / sizeof(Ch)];
         struct {
-            RefCount **data_;
+            RefCount *data_; // the heap block, starting with the reference count.
             Ch *first_;
             Ch *last_;
             Ch *end_;
@@ -1559,6 +2026,19 @@ private:
     static constexpr SizeType kSmallLen = kSmallCap - 1;
     static constexpr SizeType kMinCap = (sizeof(Ch *) * 8) / sizeof(Ch);
 
+    // Written by whoever hashes a shared block first, thus concurrently by threads sharing it.
+    using HashSlot = std::atomic<SizeType>;
+
+    static constexpr SizeType kHashOffset =
+            (sizeof(RefCount) + alignof(HashSlot) - 1) / alignof(HashSlot) * alignof(HashSlot);
+
+    /**
+     * The size of the block header holding the reference count and the cached hash,
+     * padded so that the characters stay aligned.
+     */
+    static constexpr SizeType kHeader =
+            (kHashOffset + sizeof(HashSlot) + alignof(Ch) - 1) / alignof(Ch) * alignof(Ch);
+
     static constexpr SizeType Cap(SizeType len) {
         if (len) {
             if (len <= kMinCap) {
@@ -1570,8 +2050,35 @@ private:
         return 0;
     }
 
+    /**
+     * The heap block is laid out as [ RefCount | hash | first_ ... last_ | ... end_ | terminator ],
+     * thus a full block still has room for the null terminator.
+     */
     static constexpr SizeType TotCap(SizeType capacity) {
-        return sizeof(RefCount *) + capacity * sizeof(Ch);
+        return kHeader + (capacity + 1) * sizeof(Ch);
+    }
+
+    Ch *Origin() const noexcept {
+        return reinterpret_cast<Ch *>(reinterpret_cast<unsigned char *>(data_) + kHeader);
+    }
+
+    /**
+     * @return the hash cached in the heap block, 0 if it is not computed yet
+     */
+    HashSlot *CachedHash() const noexcept {
+        return reinterpret_cast<HashSlot *>(reinterpret_cast<unsigned char *>(data_) + kHashOffset);
+    }
+
+    /**
+     * Takes another reference to the heap block.
+     * A block only caches its hash while it is shared, and shared blocks are never modified,
+     * but an unshared one may have been modified in place since, so its old hash is dropped here.
+     */
+    void Share() const noexcept {
+        if (data_->Value() == 1) {
+            CachedHash()->store(0, std::memory_order_relaxed);
+        }
+        data_->IncrementRef();
     }
 
     SizeType SmallLength() const noexcept {
@@ -1585,14 +2092,39 @@ private:
         }
     }
 
-    Ch *SimpleAllocate(const SizeType &len, RefCount *const &rc) {
-        if (len > kSmallLen) {
+    /**
+     * @return true if \p view refers to the storage of this instance, which may move when the instance is modified.
+     */
+    bool Overlaps(BasicStringView<Ch> view) const noexcept {
+        const Ch *str(ConstData());
+        std::less<const Ch *> less;
+        return str && view.ConstData() && !less(view.ConstData(), str) && less(view.ConstData(), str + Capacity() + 1);
+    }
+
+    /**
+     * Uses the small buffer if \p len characters fit in it, otherwise allocates a block with room to grow.
+     * The previous storage is the caller's business, and so is first_, which the small buffer overwrites.
+     * @return the address of the first character
+     */
+    Ch *SimpleAllocate(const SizeType &len) {
+        return SimpleAllocate(len, len > kSmallLen ? Cap(len) : len);
+    }
+
+    /**
+     * Switches to the small buffer if \p cap fits in it, otherwise allocates a block owned by this instance only.
+     * Callers which need a heap block whatever the length, such as StringPool, pass a \p cap above kSmallLen.
+     * Simple means it neither releases the previous block nor copies any character.
+     * @return the address of the first character
+     */
+    Ch *SimpleAllocate(const SizeType &len, const SizeType &cap) {
+        assert(len <= cap);
+        if (cap > kSmallLen || len > kSmallLen) { // the length is tested too, so that compilers see the bounds.
             mode_ = Mode::Allocate;
-            SizeType cap(Cap(len));
-            data_ = static_cast<RefCount **>(::malloc(TotCap(cap)));
-            assert(data_);
-            *data_ = rc;
-            first_ = (Ch *) (data_ + 1);
+            void *block = ::malloc(TotCap(cap));
+            assert(block);
+            data_ = new(block)RefCount(1);
+            new(CachedHash())HashSlot(0);
+            first_ = Origin();
             last_ = first_ + len;
             end_ = first_ + cap;
             *last_ = Ch(0);
@@ -1604,33 +2136,52 @@ private:
         }
     }
 
-    Ch *SimpleAllocate(const SizeType &len, const SizeType &cap, RefCount *const &rc) {
-        if (cap > kSmallCap) {
-            mode_ = Mode::Allocate;
-            data_ = static_cast<RefCount **>(::malloc(TotCap(cap)));
-            assert(data_);
-            *data_ = rc;
-            first_ = (Ch *) (data_ + 1);
-            last_ = first_ + len;
-            end_ = first_ + cap;
-            *last_ = Ch(0);
-            return first_;
-        } else {
-            mode_ = Mode::Small;
-            SetSmallLength(len, true);
-            return small_;
+    /**
+     * Resizes the block of an unshared instance, the header moves along with it.
+     * @return the address of the first character
+     */
+    Ch *SimpleReallocate(const SizeType &len, const SizeType &cap) {
+        RefCount *old_data = data_;
+        data_ = static_cast<RefCount *>(::realloc(data_, TotCap(cap)));
+        assert(data_);
+        if (data_ != old_data) {
+            first_ = Origin();
+        }
+        last_ = first_ + len;
+        end_ = first_ + cap;
+        *last_ = Ch(0);
+        return first_;
+    }
+
+    void SimpleFree() {
+        ::free(static_cast<void *>(data_));
+    }
+
+    /**
+     * Turns a slice into an instance owning a copy of its characters, before it is modified.
+     */
+    void Detach() {
+        RefCount *old_data = data_;
+        const Ch *old = first_;
+        SizeType len = last_ - first_;
+        ICharTrait<Ch>::Copy(SimpleAllocate(len), old, len);
+        if (old_data->Value() == 1 || old_data->ReleaseRef()) {
+            ::free(static_cast<void *>(old_data));
         }
     }
 
     Ch *GrowthAppend(const SizeType &count) {
+        if (mode_ == Mode::Slice) {
+            BasicString<Ch, Thread>::Detach();
+        }
         if (mode_ == Mode::Null) {
-            return SimpleAllocate(count, nullptr);
+            return SimpleAllocate(count);
         } else if (mode_ == Mode::Small) {
             SizeType old_len(SmallLength()), new_len(old_len + count);
             if (new_len > kSmallLen) {
                 Ch old[kSmallCap];
                 ICharTrait<Ch>::Copy(old, small_, old_len);
-                Ch *pos = SimpleAllocate(new_len, nullptr);
+                Ch *pos = SimpleAllocate(new_len);
                 if (pos) {
                     ICharTrait<Ch>::Copy(pos, old, old_len);
                 }
@@ -1642,85 +2193,73 @@ private:
         } else {
             if (data_) {
                 SizeType old_len(last_ - first_), new_len(old_len + count);
-                if (*data_ && (**data_).Value() > 1) {
-                    (**data_).DecrementRef();
-                    Ch *old = first_, *pos = SimpleAllocate(new_len, nullptr);
+                if (data_->Value() > 1) {
+                    data_->DecrementRef();
+                    Ch *old = first_, *pos = SimpleAllocate(new_len);
                     if (pos) {
                         ICharTrait<Ch>::Copy(pos, old, old_len);
                     }
                     return pos + old_len;
                 } else {
-                    if (new_len >= end_ - first_) {
-                        SizeType new_cap(Cap(new_len));
-                        RefCount **old_data = data_;
-                        RefCount *old_ref = *data_;
-                        data_ = static_cast<RefCount **>(::realloc(data_, TotCap(new_cap)));
-                        if (data_ != old_data) {
-                            first_ = (Ch *) (data_ + 1);
-                            *data_ = old_ref;
-                        }
-                        last_ = first_ + new_len;
-                        end_ = first_ + new_cap;
+                    if (new_len > SizeType(end_ - first_)) {
+                        SimpleReallocate(new_len, Cap(new_len));
                     } else {
                         last_ += count;
+                        *last_ = Ch(0);
                     }
                     return first_ + old_len;
                 }
             } else {
-                return SimpleAllocate(count, nullptr);
+                return SimpleAllocate(count);
             }
         }
     }
 
     Ch *GrowthPrepend(const SizeType &count) {
+        if (mode_ == Mode::Slice) {
+            BasicString<Ch, Thread>::Detach();
+        }
         if (mode_ == Mode::Null) {
-            return SimpleAllocate(count, nullptr);
+            return SimpleAllocate(count);
         } else if (mode_ == Mode::Small) {
             SizeType old_len(SmallLength()), new_len(old_len + count);
             if (new_len > kSmallLen) {
                 Ch old[kSmallCap];
                 ICharTrait<Ch>::Copy(old, small_, old_len);
-                Ch *pos = SimpleAllocate(new_len, nullptr);
+                Ch *pos = SimpleAllocate(new_len);
                 if (pos) {
                     ICharTrait<Ch>::Copy(pos + count, old, old_len);
                 }
                 return pos;
             } else {
-                SetSmallLength(new_len, true);
                 ICharTrait<Ch>::Move(small_ + count, small_, old_len);
+                SetSmallLength(new_len, true);
                 return small_;
             }
         } else {
             SizeType old_len(last_ - first_), new_len(old_len + count);
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
-                Ch *old_str(first_), *new_str(SimpleAllocate(new_len, nullptr));
-                if (new_str) {
-                    ICharTrait<Ch>::Copy(new_str + count, old_str, old_len);
-                }
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
+                Ch *old_str(first_), *new_str(SimpleAllocate(new_len));
+                ICharTrait<Ch>::Copy(new_str + count, old_str, old_len);
+                return new_str; // may be the small buffer, whose bytes overlap first_.
             } else {
                 SizeType old_cap(end_ - first_);
-                if (new_len < old_cap) {
-                    last_ += count;
+                if (new_len <= old_cap) {
                     ICharTrait<Ch>::Move(first_ + count, first_, old_len);
+                    last_ += count;
+                    *last_ = Ch(0);
                 } else {
                     SizeType new_cap(Cap(new_len));
                     if (new_cap - old_cap > old_cap * 2) {
-                        RefCount **old_data = data_;
-                        RefCount *old_ref = *data_;
+                        // most of the old block would be copied for nothing, copy only the characters.
+                        RefCount *old_data = data_;
                         Ch *old_str = first_;
-                        Ch *new_str(SimpleAllocate(new_len, old_ref));
+                        Ch *new_str(SimpleAllocate(new_len, new_cap));
                         ICharTrait<Ch>::Copy(new_str + count, old_str, old_len);
-                        ::free((void *) data_);
+                        ::free(static_cast<void *>(old_data));
                     } else {
-                        RefCount **old_data = data_;
-                        RefCount *old_ref = *data_;
-                        data_ = static_cast<RefCount **>(::realloc(data_, TotCap(new_cap)));
-                        if (data_ != old_data) {
-                            first_ = (Ch *) (data_ + 1);
-                        }
-                        last_ = first_ + new_len;
-                        end_ = first_ + new_cap;
+                        SimpleReallocate(new_len, new_cap);
                         ICharTrait<Ch>::Move(first_ + count, first_, old_len);
                     }
                 }
@@ -1730,55 +2269,52 @@ private:
     }
 
     Ch *GrowthInsert(const SizeType &index, const SizeType &count) {
-        if (mode_ == Mode::Small) {
+        if (mode_ == Mode::Slice) {
+            BasicString<Ch, Thread>::Detach();
+        }
+        if (mode_ == Mode::Null) {
+            return SimpleAllocate(count);
+        } else if (mode_ == Mode::Small) {
             SizeType old_len(SmallLength()), new_len(old_len + count);
             if (new_len > kSmallLen) {
                 Ch old[kSmallCap];
                 ICharTrait<Ch>::Copy(old, small_, old_len);
-                Ch *pos = SimpleAllocate(new_len, nullptr);
+                Ch *pos = SimpleAllocate(new_len);
                 if (pos) {
                     ICharTrait<Ch>::Copy(pos, old, index);
                     ICharTrait<Ch>::Copy(pos + index + count, old + index, old_len - index);
                 }
                 return pos + index;
             } else {
-                SetSmallLength(new_len, true);
                 ICharTrait<Ch>::Move(small_ + index + count, small_ + index, old_len - index);
+                SetSmallLength(new_len, true);
                 return small_ + index;
             }
         } else {
             SizeType old_len(last_ - first_), new_len(old_len + count);
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
-                Ch *old_str(first_), *new_str(SimpleAllocate(new_len, nullptr));
-                if (new_str) {
-                    ICharTrait<Ch>::Copy(new_str, old_str, index);
-                    ICharTrait<Ch>::Copy(new_str + index + count, old_str + index, old_len - index);
-                }
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
+                Ch *old_str(first_), *new_str(SimpleAllocate(new_len));
+                ICharTrait<Ch>::Copy(new_str, old_str, index);
+                ICharTrait<Ch>::Copy(new_str + index + count, old_str + index, old_len - index);
+                return new_str + index; // may be the small buffer, whose bytes overlap first_.
             } else {
                 SizeType old_cap(end_ - first_);
-                if (new_len < old_cap) {
-                    last_ += count;
+                if (new_len <= old_cap) {
                     ICharTrait<Ch>::Move(first_ + index + count, first_ + index, old_len - index);
+                    last_ += count;
+                    *last_ = Ch(0);
                 } else {
                     SizeType new_cap(Cap(new_len));
                     if (new_cap - old_cap > old_cap * 2) {
-                        RefCount **old_data = data_;
-                        RefCount *old_ref = *data_;
+                        RefCount *old_data = data_;
                         Ch *old_str = first_;
-                        Ch *new_str(SimpleAllocate(new_len, old_ref));
+                        Ch *new_str(SimpleAllocate(new_len, new_cap));
                         ICharTrait<Ch>::Copy(new_str, old_str, index);
                         ICharTrait<Ch>::Copy(new_str + index + count, old_str + index, old_len - index);
-                        ::free((void *) data_);
+                        ::free(static_cast<void *>(old_data));
                     } else {
-                        RefCount **old_data = data_;
-                        RefCount *old_ref = *data_;
-                        data_ = static_cast<RefCount **>(::realloc(data_, TotCap(new_cap)));
-                        if (data_ != old_data) {
-                            first_ = (Ch *) (data_ + 1);
-                        }
-                        last_ = first_ + new_len;
-                        end_ = first_ + new_cap;
+                        SimpleReallocate(new_len, new_cap);
                         ICharTrait<Ch>::Move(first_ + index + count, first_ + index, old_len - index);
                     }
                 }
@@ -1788,41 +2324,48 @@ private:
     }
 
     Ch *AssignImpl(SizeType new_len) {
+        if (mode_ == Mode::Slice) { // the old characters are overwritten, thus only the reference is dropped.
+            if (data_->Value() == 1 || data_->ReleaseRef()) {
+                BasicString<Ch, Thread>::SimpleFree();
+            }
+            return SimpleAllocate(new_len);
+        }
         if (mode_ == Mode::Null) {
-            return SimpleAllocate(new_len, nullptr);
+            return SimpleAllocate(new_len);
         } else if (mode_ == Mode::Small) {
-            SizeType old_len(SmallLength());
-            if (new_len < kSmallLen) {
+            if (new_len <= kSmallLen) {
                 SetSmallLength(new_len, true);
                 return small_;
             } else {
-                return SimpleAllocate(new_len, nullptr);
+                return SimpleAllocate(new_len);
             }
         } else {
-            if (*data_ && (**data_).Value() > 1) {
-                (**data_).DecrementRef();
-                return SimpleAllocate(new_len, nullptr);
+            if (data_->Value() > 1) {
+                data_->DecrementRef();
+                return SimpleAllocate(new_len);
             } else {
                 SizeType old_cap(end_ - first_);
-                if (new_len < old_cap) {
+                if (new_len <= old_cap) {
                     last_ = first_ + new_len;
+                    *last_ = Ch(0);
+                    return first_;
                 } else {
-                    SizeType new_cap(Cap(new_len));
-                    RefCount **old_data = data_;
-                    RefCount *old_ref = *data_;
-                    data_ = static_cast<RefCount **>(::realloc(data_, TotCap(new_cap)));
-                    if (data_ != old_data) {
-                        first_ = (Ch *) (data_ + 1);
-                        *data_ = old_ref;
-                    }
-                    last_ = first_ + new_len;
-                    end_ = first_ + new_cap;
+                    return SimpleReallocate(new_len, Cap(new_len));
                 }
-                *last_ = Ch(0);
-                return first_;
             }
         }
     }
 };
 
+namespace Internal {
+    /**
+     * The small buffer of a BasicString holds characters only, and the allocated mode
+     * only holds pointers to its heap block, thus it can be relocated bitwise.
+     */
+    template<typename Ch, typename Thread>
+    struct TypeTraitPatternDefiner<BasicString<Ch, Thread>> {
+        static const TypeTraitPattern Pattern = TypeTraitPattern::Relocatable;
+    };
+}
+
 #endif //ESCAPIST_STRING_H
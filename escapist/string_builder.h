@@ -0,0 +1,204 @@
+/**
+ * Chunked string building.
+ *
+ * A StringBuilder keeps its content as a List of BasicString chunks and only joins
+ * them once, in ToString(). Appending and prepending cost O(1) amortized regardless
+ * of the length built so far, since the List keeps room at both of its ends:
+ *  - a piece shorter than kChunkMin is copied into the chunk at that end while the
+ *    chunk is short, so that small pieces do not end up as many tiny chunks.
+ *  - a longer BasicString becomes a chunk on its own, sharing its block, thus
+ *    nothing is copied until ToString().
+ * Insert() walks the chunks to find the position, then splits the chunk there into two
+ * substrings, which share its block as well.
+ */
+
+#ifndef ESCAPIST_STRING_BUILDER_H
+#define ESCAPIST_STRING_BUILDER_H
+
+#include "base.h"
+#include "thread_policy.h"
+#include "string.h"
+#include "list.h"
+#include <cassert>
+
+/**
+ * @tparam Ch the type of characters
+ * @tparam Thread the thread policy of the chunks and of the built string, see thread_policy.h
+ */
+template<typename Ch, typename Thread = MultiThreadPolicy>
+class StringBuilder {
+public:
+    using String = BasicString<Ch, Thread>;
+
+    // Pieces shorter than this are merged into the chunk at the end they are added to.
+    static constexpr SizeType kChunkMin = 256;
+
+    StringBuilder() = default;
+
+    /**
+     * @return the total amount of characters
+     */
+    SizeType Length() const noexcept {
+        return length_;
+    }
+
+    bool IsEmpty() const noexcept {
+        return !length_;
+    }
+
+    SizeType ChunkCount() const noexcept {
+        return chunks_.Count();
+    }
+
+    /**
+     * Adds a copy of the characters of \p view at the end.
+     * @return the current instance
+     */
+    StringBuilder &Append(BasicStringView<Ch> view) {
+        if (view.IsEmpty()) {
+            return *this;
+        }
+        length_ += view.Length();
+        if (chunks_.Count() && chunks_.ConstData()[chunks_.Count() - 1].Length() < kChunkMin) {
+            chunks_.At(chunks_.Count() - 1).Append(view);
+        } else {
+            chunks_.Append(String(view));
+        }
+        return *this;
+    }
+
+    StringBuilder &Append(const Ch *str) {
+        return StringBuilder::Append(BasicStringView<Ch>(str));
+    }
+
+    /**
+     * Adds \p str at the end, sharing its block unless it is shorter than kChunkMin.
+     * @return the current instance
+     */
+    StringBuilder &Append(const String &str) {
+        if (str.Length() < kChunkMin) {
+            return StringBuilder::Append(BasicStringView<Ch>(str));
+        }
+        length_ += str.Length();
+        chunks_.Append(str);
+        return *this;
+    }
+
+    /**
+     * Adds a copy of the characters of \p view at the front.
+     * @return the current instance
+     */
+    StringBuilder &Prepend(BasicStringView<Ch> view) {
+        if (view.IsEmpty()) {
+            return *this;
+        }
+        length_ += view.Length();
+        if (chunks_.Count() && chunks_.ConstData()[0].Length() < kChunkMin) {
+            chunks_.At(0).Prepend(view);
+        } else {
+            chunks_.Prepend(String(view));
+        }
+        return *this;
+    }
+
+    StringBuilder &Prepend(const Ch *str) {
+        return StringBuilder::Prepend(BasicStringView<Ch>(str));
+    }
+
+    /**
+     * Adds \p str at the front, sharing its block unless it is shorter than kChunkMin.
+     * @return the current instance
+     */
+    StringBuilder &Prepend(const String &str) {
+        if (str.Length() < kChunkMin) {
+            return StringBuilder::Prepend(BasicStringView<Ch>(str));
+        }
+        length_ += str.Length();
+        chunks_.Prepend(str);
+        return *this;
+    }
+
+    /**
+     * Inserts a copy of the characters of \p view before the character at \p index.
+     * Takes O(n) in the amount of chunks to find the position.
+     * @param index the position, no larger than the length
+     * @return the current instance
+     */
+    StringBuilder &Insert(SizeType index, BasicStringView<Ch> view) {
+        if (view.IsEmpty()) {
+            return *this;
+        }
+        return StringBuilder::InsertChunk(index, String(view));
+    }
+
+    StringBuilder &Insert(SizeType index, const Ch *str) {
+        return StringBuilder::Insert(index, BasicStringView<Ch>(str));
+    }
+
+    /**
+     * Inserts \p str before the character at \p index, sharing its block unless it is shorter than kChunkMin.
+     * @param index the position, no larger than the length
+     * @return the current instance
+     */
+    StringBuilder &Insert(SizeType index, const String &str) {
+        if (str.IsEmpty()) {
+            return *this;
+        }
+        return StringBuilder::InsertChunk(index, str);
+    }
+
+    StringBuilder &Clear() {
+        chunks_.Clear();
+        length_ = 0;
+        return *this;
+    }
+
+    /**
+     * Joins the chunks into one string, with a single allocation.
+     * A builder of a single chunk gives a copy of it, which shares its block.
+     * @return the built string
+     */
+    String ToString() const {
+        if (chunks_.Count() == 1) {
+            return chunks_.ConstData()[0];
+        }
+        String rtn;
+        rtn.EnsureCapacity(length_);
+        const String *chunk = chunks_.ConstData();
+        for (const String *end = chunk + chunks_.Count(); chunk != end; ++chunk) {
+            rtn.Append(BasicStringView<Ch>(*chunk));
+        }
+        return rtn;
+    }
+
+private:
+    StringBuilder &InsertChunk(SizeType index, const String &str) {
+        assert(index <= length_);
+        if (!index) {
+            return StringBuilder::Prepend(str);
+        } else if (index == length_) {
+            return StringBuilder::Append(str);
+        }
+        SizeType i = 0;
+        for (const String *chunk = chunks_.ConstData(); index > chunk[i].Length(); ++i) {
+            index -= chunk[i].Length();
+        }
+        length_ += str.Length();
+        String &chunk = chunks_.At(i);
+        if (index == chunk.Length()) {
+            chunks_.Insert(i + 1, str);
+        } else if (chunk.Length() < kChunkMin) {
+            chunk.Insert(index, BasicStringView<Ch>(str));
+        } else {
+            String parts[2] = {str, chunk.Substring(index)};
+            chunk.Assign(chunk.Substring(0, index));
+            chunks_.Insert(i + 1, parts, 2);
+        }
+        return *this;
+    }
+
+    List<String> chunks_;
+    SizeType length_ = 0;
+};
+
+#endif //ESCAPIST_STRING_BUILDER_H
@@ -0,0 +1,159 @@
+/**
+ * String interning.
+ *
+ * A StringPool keeps one canonical BasicString per distinct content and hands out
+ * copies of it, which share its heap block through the reference count. Thus a
+ * pool of identifiers seen millions of times holds each of them only once, and two
+ * interned strings are equal exactly when they point to the same characters.
+ *
+ * Canonical strings are always heap-allocated, even the short ones that would fit in
+ * the small buffer, otherwise their copies would not share anything.
+ *
+ * The table is an open-addressing hash table with linear probing, locked by the
+ * \c Mutex of the thread policy: a std::mutex for MultiThreadPolicy, nothing otherwise.
+ */
+
+#ifndef ESCAPIST_STRING_POOL_H
+#define ESCAPIST_STRING_POOL_H
+
+#include "base.h"
+#include "thread_policy.h"
+#include "string.h"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+/**
+ * Interned strings stay alive at least as long as the pool, which never shrinks.
+ * @tparam Ch the type of characters
+ * @tparam Thread the thread policy of the interned strings, which must be shareable
+ */
+template<typename Ch, typename Thread = MultiThreadPolicy>
+class StringPool {
+public:
+    using String = BasicString<Ch, Thread>;
+
+    static_assert(Thread::kShareable, "interned strings must share their block");
+
+    StringPool() = default;
+
+    ~StringPool() {
+        for (SizeType i = 0; i < slot_count_; ++i) {
+            slots_[i].str_.~String();
+        }
+        ::free(static_cast<void *>(slots_));
+    }
+
+    StringPool(const StringPool &other) = delete;
+
+    StringPool &operator=(const StringPool &other) = delete;
+
+    /**
+     * Finds the canonical string equal to \p view, or adds a copy of \p view if there is none.
+     * @return a copy of the canonical string, the empty string if \p view is empty
+     */
+    String Intern(BasicStringView<Ch> view) {
+        if (view.IsEmpty()) {
+            return String();
+        }
+        SizeType hash = view.Hash();
+        std::lock_guard<Mutex> lock(mutex_);
+        if ((count_ + 1) * 4 > slot_count_ * 3) {
+            StringPool::Rehash(slot_count_ ? slot_count_ * 2 : kMinSlots);
+        }
+        Slot &slot = slots_[StringPool::Probe(view, hash)];
+        if (slot.str_.IsEmpty()) {
+            SizeType len = view.Length(), cap = len > String::kSmallLen ? len : SizeType(String::kSmallCap);
+            ICharTrait<Ch>::Copy(slot.str_.SimpleAllocate(len, cap), view.ConstData(), len);
+            slot.hash_ = hash;
+            ++count_;
+        }
+        return slot.str_;
+    }
+
+    /**
+     * @return a copy of the canonical string equal to \p view, or the empty string if it is not interned
+     */
+    String Find(BasicStringView<Ch> view) const {
+        if (view.IsEmpty()) {
+            return String();
+        }
+        SizeType hash = view.Hash();
+        std::lock_guard<Mutex> lock(mutex_);
+        if (!count_) {
+            return String();
+        }
+        return slots_[StringPool::Probe(view, hash)].str_;
+    }
+
+    /**
+     * @return the amount of distinct strings in the pool
+     */
+    SizeType Count() const {
+        std::lock_guard<Mutex> lock(mutex_);
+        return count_;
+    }
+
+    /**
+     * Compares two strings interned by the same pool, by the address of their characters only.
+     * @return true if both strings are equal
+     */
+    static bool Same(const String &left, const String &right) noexcept {
+        return left.ConstData() == right.ConstData() && left.Length() == right.Length();
+    }
+
+private:
+    using Mutex = typename Thread::Mutex;
+
+    static constexpr SizeType kMinSlots = 16;
+
+    // an empty slot holds the empty string, which is never interned.
+    struct Slot {
+        String str_;
+        SizeType hash_;
+    };
+
+    /**
+     * @return the slot holding \p view, or the empty slot where it would be added
+     */
+    SizeType Probe(BasicStringView<Ch> view, SizeType hash) const {
+        SizeType mask = slot_count_ - 1;
+        for (SizeType index = hash & mask;; index = (index + 1) & mask) {
+            const Slot &slot = slots_[index];
+            if (slot.str_.IsEmpty() || (slot.hash_ == hash && slot.str_.Equals(view))) {
+                return index;
+            }
+        }
+    }
+
+    /**
+     * Moves every canonical string into a table of \p slot_count slots, a power of two.
+     * Strings are relocatable, thus they are moved bitwise and the old table is freed without destructors.
+     */
+    void Rehash(SizeType slot_count) {
+        Slot *old_slots = slots_;
+        SizeType old_count = slot_count_;
+        slots_ = static_cast<Slot *>(::malloc(slot_count * sizeof(Slot)));
+        assert(slots_);
+        slot_count_ = slot_count;
+        for (SizeType i = 0; i < slot_count; ++i) {
+            new(&slots_[i].str_)String();
+        }
+        for (SizeType i = 0; i < old_count; ++i) {
+            if (!old_slots[i].str_.IsEmpty()) {
+                ::memcpy(static_cast<void *>(&slots_[StringPool::Probe(old_slots[i].str_, old_slots[i].hash_)]),
+                         static_cast<const void *>(&old_slots[i]), sizeof(Slot));
+            }
+        }
+        ::free(static_cast<void *>(old_slots));
+    }
+
+    Slot *slots_ = nullptr;
+    SizeType slot_count_ = 0;
+    SizeType count_ = 0;
+    mutable Mutex mutex_;
+};
+
+#endif //ESCAPIST_STRING_POOL_H
@@ -0,0 +1,60 @@
+/**
+ * Thread policies for the copy-on-write containers in this library.
+ *
+ * Copying a List or a BasicString shares the heap block and counts the owners,
+ * the block is only duplicated when a sharing instance is about to change. A
+ * policy decides how that count is kept:
+ *  - RefCount: the counter type, with Value/IncrementRef/DecrementRef.
+ *  - kShareable: false to make every copy a deep copy, thus no count is ever
+ *    created and the copy-on-write checks never succeed.
+ *  - Mutex: the lock of structures shared by many instances, such as StringPool.
+ *
+ * Three policies are provided:
+ *  - MultiThreadPolicy: an atomic count, the default. Copies may be handed to
+ *    other threads freely.
+ *  - SingleThreadPolicy: a plain integer count. Every instance sharing a block
+ *    must stay on one thread.
+ *  - UnsharedPolicy: no sharing at all, for containers that are rarely copied.
+ */
+
+#ifndef ESCAPIST_THREAD_POLICY_H
+#define ESCAPIST_THREAD_POLICY_H
+
+#include "base.h"
+#include "internal/ref_count.h"
+#include <mutex>
+
+namespace Internal {
+    /**
+     * A lock that does nothing, for policies whose instances never leave their thread.
+     */
+    struct NullMutex {
+        void lock() noexcept {}
+
+        bool try_lock() noexcept {
+            return true;
+        }
+
+        void unlock() noexcept {}
+    };
+}
+
+struct MultiThreadPolicy {
+    using RefCount = Internal::ReferenceCount;
+    using Mutex = std::mutex;
+    static constexpr bool kShareable = true;
+};
+
+struct SingleThreadPolicy {
+    using RefCount = Internal::PlainReferenceCount;
+    using Mutex = Internal::NullMutex;
+    static constexpr bool kShareable = true;
+};
+
+struct UnsharedPolicy {
+    using RefCount = Internal::PlainReferenceCount;
+    using Mutex = Internal::NullMutex;
+    static constexpr bool kShareable = false;
+};
+
+#endif //ESCAPIST_THREAD_POLICY_H
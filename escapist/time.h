@@ -0,0 +1,285 @@
+/**
+ * Timing of hot paths.
+ *
+ * Clocks are structs of static functions, just like the policies of the containers:
+ *  - MonotonicClock: nanoseconds since an arbitrary point, never going backwards.
+ *    It reads the OS clock directly, without std::chrono conversions.
+ *  - CycleClock: the time stamp counter on x86, a few cycles per read. The counter
+ *    is converted to nanoseconds by a ratio calibrated once against
+ *    std::chrono::steady_clock, which assumes an invariant TSC (any x86 of the
+ *    last decade). Other architectures fall back to MonotonicClock.
+ *
+ * LatencyHistogram records durations without locks. Every thread records into its
+ * own shard with relaxed atomics, so that recording threads rarely share a cache line,
+ * and the shards are only merged when the histogram is read.
+ * ScopedTimer measures the lifetime of a scope into a histogram or a counter.
+ */
+
+#ifndef ESCAPIST_TIME_H
+#define ESCAPIST_TIME_H
+
+#include "base.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(ESCAPIST_OS_WINDOWS)
+#include <windows.h>
+#elif defined(ESCAPIST_OS_LINUX) || defined(ESCAPIST_OS_MACOS) || defined(ESCAPIST_OS_UNIX)
+#include <time.h>
+#define ESCAPIST_CLOCK_GETTIME
+#endif
+
+#if defined(ESCAPIST_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+struct MonotonicClock {
+    /**
+     * @return the nanoseconds elapsed since an arbitrary point, the same for every thread
+     */
+    static std::int64_t Now() noexcept {
+#if defined(ESCAPIST_OS_WINDOWS)
+        static const std::int64_t frequency = [] {
+            LARGE_INTEGER rtn;
+            QueryPerformanceFrequency(&rtn);
+            return std::int64_t(rtn.QuadPart);
+        }();
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        std::int64_t value = counter.QuadPart;
+        return value / frequency * 1000000000 + value % frequency * 1000000000 / frequency;
+#elif defined(ESCAPIST_CLOCK_GETTIME)
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return std::int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+};
+
+struct CycleClock {
+    // Whether Now() reads a hardware counter, otherwise it gives the nanoseconds of MonotonicClock.
+#if defined(ESCAPIST_ARCH_X86)
+    static constexpr bool kHardware = true;
+#else
+    static constexpr bool kHardware = false;
+#endif
+
+    // How long the first conversion to nanoseconds waits to calibrate the counter.
+    static constexpr std::int64_t kCalibrationNanoseconds = 10000000;
+
+    /**
+     * @return the current value of the counter, only meaningful as a difference between two reads on one machine
+     */
+    static std::uint64_t Now() noexcept {
+#if defined(ESCAPIST_ARCH_X86)
+        return __rdtsc();
+#else
+        return std::uint64_t(MonotonicClock::Now());
+#endif
+    }
+
+    /**
+     * Calibrates the counter on the first call, which blocks for kCalibrationNanoseconds.
+     * @return the nanoseconds per tick of the counter
+     */
+    static double NanosecondsPerCycle() {
+        static const double rtn = CycleClock::Calibrate();
+        return rtn;
+    }
+
+    /**
+     * @return \p cycles ticks of the counter in nanoseconds
+     */
+    static std::int64_t ToNanoseconds(std::uint64_t cycles) {
+        return std::int64_t(double(cycles) * NanosecondsPerCycle());
+    }
+
+private:
+    static double Calibrate() {
+        if (!kHardware) {
+            return 1.0;
+        }
+        using Steady = std::chrono::steady_clock;
+        Steady::time_point start_time = Steady::now();
+        std::uint64_t start = Now();
+        std::this_thread::sleep_for(std::chrono::nanoseconds(std::int64_t(kCalibrationNanoseconds)));
+        std::uint64_t end = Now();
+        std::int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Steady::now() - start_time).count();
+        return end > start ? double(elapsed) / double(end - start) : 1.0;
+    }
+};
+
+namespace Internal {
+    /**
+     * @return a number fixed for the calling thread, handed out in order of the first call
+     */
+    inline SizeType ThreadSlot() noexcept {
+        static std::atomic<SizeType> next(0);
+        static thread_local SizeType slot = next.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+}
+
+/**
+ * A histogram of durations in nanoseconds, with a relative error of at most 1 / 2^kSubBits.
+ * Buckets are log-linear: every power of two is split into 2^kSubBits buckets of equal width.
+ * Recording is lock-free, reading merges every shard and may miss values recorded meanwhile.
+ */
+class LatencyHistogram {
+public:
+    static constexpr SizeType kSubBits = 3;
+    static constexpr SizeType kBuckets = (64 - kSubBits + 1) << kSubBits;
+    static constexpr SizeType kShards = 8;
+
+    LatencyHistogram() noexcept {
+        Reset();
+    }
+
+    LatencyHistogram(const LatencyHistogram &other) = delete;
+
+    LatencyHistogram &operator=(const LatencyHistogram &other) = delete;
+
+    /**
+     * @param nanoseconds a duration, negative ones count as 0
+     */
+    void Record(std::int64_t nanoseconds) noexcept {
+        std::uint64_t value = nanoseconds > 0 ? std::uint64_t(nanoseconds) : 0;
+        Shard &shard = shards_[Internal::ThreadSlot() % kShards];
+        shard.buckets_[Bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.count_.fetch_add(1, std::memory_order_relaxed);
+        shard.sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Count() const noexcept {
+        std::uint64_t rtn = 0;
+        for (const Shard &shard: shards_) {
+            rtn += shard.count_.load(std::memory_order_relaxed);
+        }
+        return rtn;
+    }
+
+    /**
+     * @return the average duration, 0 if nothing is recorded
+     */
+    double Mean() const noexcept {
+        std::uint64_t count = 0, sum = 0;
+        for (const Shard &shard: shards_) {
+            count += shard.count_.load(std::memory_order_relaxed);
+            sum += shard.sum_.load(std::memory_order_relaxed);
+        }
+        return count ? double(sum) / double(count) : 0.0;
+    }
+
+    /**
+     * @param fraction the rank in [0, 1], such as 0.99 for the 99th percentile
+     * @return the upper bound of the bucket holding that rank, 0 if nothing is recorded
+     */
+    std::uint64_t Percentile(double fraction) const noexcept {
+        std::uint64_t counts[kBuckets] = {}, total = 0;
+        for (const Shard &shard: shards_) {
+            for (SizeType i = 0; i < kBuckets; ++i) {
+                std::uint64_t count = shard.buckets_[i].load(std::memory_order_relaxed);
+                counts[i] += count, total += count;
+            }
+        }
+        if (!total) {
+            return 0;
+        }
+        std::uint64_t rank = fraction <= 0 ? 1 : fraction >= 1 ? total : std::uint64_t(fraction * double(total - 1)) + 1;
+        for (SizeType i = 0; i < kBuckets; ++i) {
+            if (counts[i] >= rank) {
+                return UpperBound(i);
+            }
+            rank -= counts[i];
+        }
+        return UpperBound(kBuckets - 1);
+    }
+
+    void Reset() noexcept {
+        for (Shard &shard: shards_) {
+            for (std::atomic<std::uint64_t> &bucket: shard.buckets_) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            shard.count_.store(0, std::memory_order_relaxed);
+            shard.sum_.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static constexpr SizeType kSubMask = (SizeType(1) << kSubBits) - 1;
+
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> buckets_[kBuckets];
+        std::atomic<std::uint64_t> count_;
+        std::atomic<std::uint64_t> sum_;
+    };
+
+    static SizeType Bucket(std::uint64_t value) noexcept {
+        if (value <= kSubMask) {
+            return SizeType(value);
+        }
+        SizeType msb = 63;
+        for (; !(value >> msb); --msb);
+        return ((msb - kSubBits + 1) << kSubBits) | SizeType((value >> (msb - kSubBits)) & kSubMask);
+    }
+
+    static std::uint64_t UpperBound(SizeType bucket) noexcept {
+        if (bucket <= kSubMask) {
+            return bucket;
+        }
+        SizeType msb = (bucket >> kSubBits) + kSubBits - 1;
+        std::uint64_t width = std::uint64_t(1) << (msb - kSubBits);
+        return ((std::uint64_t(kSubMask + 1) | (bucket & kSubMask)) << (msb - kSubBits)) + (width - 1);
+    }
+
+    Shard shards_[kShards];
+};
+
+/**
+ * Measures the time from its construction to its destruction by CycleClock,
+ * then records it into a histogram or adds it to a counter of nanoseconds.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram &histogram) noexcept
+            : histogram_(&histogram), total_(nullptr), start_(CycleClock::Now()) {}
+
+    explicit ScopedTimer(std::int64_t &total) noexcept
+            : histogram_(nullptr), total_(&total), start_(CycleClock::Now()) {}
+
+    ScopedTimer(const ScopedTimer &other) = delete;
+
+    ScopedTimer &operator=(const ScopedTimer &other) = delete;
+
+    ~ScopedTimer() {
+        std::int64_t elapsed = Elapsed();
+        if (histogram_) {
+            histogram_->Record(elapsed);
+        } else {
+            *total_ += elapsed;
+        }
+    }
+
+    /**
+     * @return the nanoseconds since the construction
+     */
+    std::int64_t Elapsed() const {
+        return CycleClock::ToNanoseconds(CycleClock::Now() - start_);
+    }
+
+private:
+    LatencyHistogram *histogram_;
+    std::int64_t *total_;
+    std::uint64_t start_;
+};
+
+#endif //ESCAPIST_TIME_H
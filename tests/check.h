@@ -0,0 +1,27 @@
+/**
+ * A minimal check macro for the tests of this library.
+ *
+ * ESCAPIST_CHECK does not depend on NDEBUG, thus the tests keep checking in release builds.
+ * A failing check prints its location and condition, and is counted by CheckFailures(),
+ * which every test returns from main so that ctest reports the failure.
+ */
+
+#ifndef ESCAPIST_TESTS_CHECK_H
+#define ESCAPIST_TESTS_CHECK_H
+
+#include <cstdio>
+
+inline int &CheckFailures() noexcept {
+    static int failures = 0;
+    return failures;
+}
+
+#define ESCAPIST_CHECK(condition)                                                   \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++CheckFailures();                                                      \
+        }                                                                           \
+    } while (false)
+
+#endif //ESCAPIST_TESTS_CHECK_H
@@ -0,0 +1,99 @@
+#include "../escapist/list.h"
+#include "check.h"
+#include <cmath>
+#include <string>
+
+/**
+ * Inserting at Count(), including into an empty list, appends.
+ */
+static void TestInsertAtEnds() {
+    List<std::string> emplaced;
+    emplaced.EmplaceAt(0, "x");
+    emplaced.EmplaceAt(1, 2, 'y');
+    emplaced.EmplaceAt(0, "w");
+    ESCAPIST_CHECK(emplaced.Count() == 3);
+    ESCAPIST_CHECK(emplaced.ConstAt(0) == "w" && emplaced.ConstAt(1) == "x" && emplaced.ConstAt(2) == "yy");
+    List<std::string> inserted;
+    inserted.Insert(0, std::string("b"));
+    inserted.Insert(1, std::string("d"));
+    inserted.Insert(1, std::string("c"));
+    inserted.Insert(0, std::string("a"));
+    const std::string tail[] = {"e", "f"};
+    inserted.Insert(inserted.Count(), tail, 2);
+    ESCAPIST_CHECK(inserted.Count() == 6);
+    std::string joined;
+    for (const std::string &value: inserted) {
+        joined += value;
+    }
+    ESCAPIST_CHECK(joined == "abcdef");
+    List<std::string> shared(inserted);
+    shared.EmplaceAt(shared.Count(), "g");
+    ESCAPIST_CHECK(shared.Count() == 7 && inserted.Count() == 6);
+}
+
+/**
+ * An element which counts how often it is moved, it is not relocatable.
+ */
+struct Moved {
+    static int moves;
+    int value;
+
+    Moved(int value) : value(value) {}
+
+    Moved(const Moved &other) = default;
+
+    Moved(Moved &&other) noexcept: value(other.value) {
+        ++moves;
+    }
+
+    Moved &operator=(const Moved &other) = default;
+};
+
+int Moved::moves = 0;
+
+static void TestInsertMany() {
+    List<Moved> list;
+    for (int i = 0; i < 8; ++i) {
+        list.Emplace(i * 10);
+    }
+    list.ShrinkToFit();
+    List<SizeType> indices{0, 3, 3, 8};
+    const Moved values[] = {-1, 25, 26, 99};
+    Moved::moves = 0;
+    list.InsertMany(indices, values);
+    ESCAPIST_CHECK(Moved::moves <= 8); // every original element moves at most once, even when the block grows.
+    const int expected[] = {-1, 0, 10, 20, 25, 26, 30, 40, 50, 60, 70, 99};
+    bool equal = list.Count() == 12;
+    for (SizeType i = 0; equal && i < 12; ++i) {
+        equal = list.ConstAt(i).value == expected[i];
+    }
+    ESCAPIST_CHECK(equal);
+    List<Moved> shared(list);
+    shared.InsertMany(List<SizeType>{12}, values);
+    ESCAPIST_CHECK(shared.Count() == 13 && list.Count() == 12 && shared.ConstAt(12).value == -1);
+}
+
+/**
+ * The radix path of StableSort must keep -0.0 and +0.0, which compare equal, in their order.
+ */
+static void TestStableSortSignedZeros() {
+    List<double> list;
+    for (int i = 0; i < 2000; ++i) {
+        list.Append(i % 2 ? -0.0 : 0.0);
+    }
+    list.Append(-1.5).Append(2.5);
+    list.StableSort();
+    ESCAPIST_CHECK(list.ConstAt(0) == -1.5 && list.ConstAt(2001) == 2.5);
+    bool stable = true;
+    for (int i = 0; i < 2000; ++i) {
+        stable = stable && std::signbit(list.ConstAt(i + 1)) == bool(i % 2);
+    }
+    ESCAPIST_CHECK(stable);
+}
+
+int main() {
+    TestInsertAtEnds();
+    TestInsertMany();
+    TestStableSortSignedZeros();
+    return CheckFailures();
+}
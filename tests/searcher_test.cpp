@@ -0,0 +1,91 @@
+#include "../escapist/searcher.h"
+#include "../escapist/string.h"
+#include "check.h"
+#include <random>
+#include <string>
+
+static const char *Find(const std::string &needle, const std::string &haystack) {
+    Searcher<char> searcher(needle.data(), needle.size());
+    return searcher.Find(haystack.data(), haystack.data() + haystack.size());
+}
+
+static const char *ReverseFind(const std::string &needle, const std::string &haystack) {
+    Searcher<char> searcher(needle.data(), needle.size());
+    return searcher.ReverseFind(haystack.data(), haystack.data() + haystack.size());
+}
+
+static SizeType Index(const char *pos, const std::string &haystack) {
+    return pos ? SizeType(pos - haystack.data()) : SizeType(-1);
+}
+
+/**
+ * A Two-Way needle whose last character occurs nowhere else in it.
+ */
+static void TestUniqueLastCharacter() {
+    std::string needle(299, 'a');
+    needle += 'b';
+    ESCAPIST_CHECK(Index(Find(needle, needle), needle) == 0);
+    std::string haystack = std::string(1000, 'a') + needle + "ccc";
+    ESCAPIST_CHECK(Index(Find(needle, haystack), haystack) == 1000);
+    ESCAPIST_CHECK(BasicString<char>(haystack.c_str()).IndexOf(needle.c_str()) == 1000);
+    std::u16string wide_needle(299, u'a'), wide_haystack(1000, u'a');
+    wide_needle += u'b';
+    wide_haystack += wide_needle;
+    ESCAPIST_CHECK(BasicString<char16_t>(wide_haystack.c_str()).IndexOf(wide_needle.c_str()) == 1000);
+}
+
+/**
+ * Inputs which make a mirrored Horspool quadratic, the reverse Two-Way stays linear on them.
+ */
+static void TestAdversarialReverse() {
+    std::string haystack(1 << 20, 'a');
+    std::string back_needle = std::string(299, 'a') + "b", front_needle = "b" + std::string(299, 'a');
+    ESCAPIST_CHECK(ReverseFind(back_needle, haystack) == nullptr);
+    ESCAPIST_CHECK(ReverseFind(front_needle, haystack) == nullptr);
+    haystack.replace(1000, 300, back_needle);
+    haystack.replace(5000, 300, front_needle);
+    for (const std::string *needle: {&back_needle, &front_needle}) {
+        ESCAPIST_CHECK(Index(ReverseFind(*needle, haystack), haystack) == SizeType(haystack.rfind(*needle)));
+        ESCAPIST_CHECK(Index(Find(*needle, haystack), haystack) == SizeType(haystack.find(*needle)));
+    }
+    std::string periodic;
+    for (int i = 0; i < 100; ++i) {
+        periodic += "abc";
+    }
+    std::string text = periodic + periodic + "ab";
+    ESCAPIST_CHECK(Index(ReverseFind(periodic, text), text) == SizeType(text.rfind(periodic)));
+}
+
+/**
+ * Compares every strategy against std::string over small alphabets, where matches are frequent.
+ */
+static void TestAgainstStd() {
+    std::mt19937 random(42);
+    const SizeType lengths[] = {1, 2, 5, 16, 17, 100, 256, 257, 300, 600};
+    for (int round = 0; round < 400; ++round) {
+        char alphabet = char('a' + 1 + random() % 3);
+        std::string haystack(random() % 4000, 'a');
+        for (char &ch: haystack) {
+            ch = char('a' + random() % (alphabet - 'a' + 1));
+        }
+        SizeType len = lengths[round % (sizeof(lengths) / sizeof(lengths[0]))];
+        std::string needle;
+        if (haystack.size() >= len && random() % 2) {
+            needle = haystack.substr(random() % (haystack.size() - len + 1), len);
+        } else {
+            needle.assign(len, 'a');
+            for (char &ch: needle) {
+                ch = char('a' + random() % (alphabet - 'a' + 1));
+            }
+        }
+        ESCAPIST_CHECK(Index(Find(needle, haystack), haystack) == SizeType(haystack.find(needle)));
+        ESCAPIST_CHECK(Index(ReverseFind(needle, haystack), haystack) == SizeType(haystack.rfind(needle)));
+    }
+}
+
+int main() {
+    TestUniqueLastCharacter();
+    TestAdversarialReverse();
+    TestAgainstStd();
+    return CheckFailures();
+}
@@ -0,0 +1,70 @@
+#include "../escapist/small_list.h"
+#include "check.h"
+#include <string>
+
+static void TestInline() {
+    SmallList<int, 4> list{3, 1, 2};
+    ESCAPIST_CHECK(list.IsSmall());
+    ESCAPIST_CHECK(list.Count() == 3);
+    ESCAPIST_CHECK(list.Capacity() == 4);
+    list.Remove(1).Prepend(0).Insert(2, 9);
+    ESCAPIST_CHECK(list.IsSmall());
+    ESCAPIST_CHECK(list.Count() == 4);
+    ESCAPIST_CHECK(list.ConstAt(0) == 0 && list.ConstAt(1) == 3 && list.ConstAt(2) == 9 && list.ConstAt(3) == 2);
+    ESCAPIST_CHECK(list.IndexOf(2) == 3 && list.IndexOf(7) == SizeType(-1));
+    list.Remove(1, 2);
+    ESCAPIST_CHECK(list.Count() == 2 && list.ConstAt(0) == 0 && list.ConstAt(1) == 2);
+}
+
+static void TestSpill() {
+    SmallList<std::string, 2> list;
+    list.Append("a").Append("b");
+    ESCAPIST_CHECK(list.IsSmall());
+    list.Insert(1, std::string("c")); // spills in the middle.
+    ESCAPIST_CHECK(!list.IsSmall());
+    ESCAPIST_CHECK(list.Count() == 3);
+    ESCAPIST_CHECK(list.ConstAt(0) == "a" && list.ConstAt(1) == "c" && list.ConstAt(2) == "b");
+    for (int i = 0; i < 100; ++i) {
+        list.Emplace(std::to_string(i));
+    }
+    list.Prepend(std::string("front"));
+    ESCAPIST_CHECK(list.Count() == 104);
+    ESCAPIST_CHECK(list.ConstAt(0) == "front" && list.ConstAt(103) == "99");
+    list.Clear();
+    ESCAPIST_CHECK(list.IsEmpty() && !list.IsSmall());
+}
+
+static void TestCopyAndMove() {
+    SmallList<std::string, 2> small{"x", "y"};
+    SmallList<std::string, 2> small_copy(small);
+    ESCAPIST_CHECK(small_copy.Equals(small));
+    SmallList<std::string, 2> large{"x", "y", "z"};
+    SmallList<std::string, 2> large_copy(large);
+    ESCAPIST_CHECK(large_copy.ConstData() == large.ConstData()); // the spilled block is shared.
+    large_copy.At(0) = "w"; // detaches.
+    ESCAPIST_CHECK(large.ConstAt(0) == "x" && large_copy.ConstAt(0) == "w");
+    SmallList<std::string, 2> moved(std::move(large));
+    ESCAPIST_CHECK(moved.Count() == 3 && large.Count() == 0);
+}
+
+static void TestReserveAndSort() {
+    SmallList<int, 8> list{5, 3, 8, 1};
+    list.Reserve(32);
+    ESCAPIST_CHECK(!list.IsSmall() && list.Capacity() >= 32);
+    list.Sort();
+    int sum = 0, prev = 0;
+    bool sorted = true;
+    for (int value: list) {
+        sorted = sorted && prev <= value;
+        prev = value, sum += value;
+    }
+    ESCAPIST_CHECK(sorted && sum == 17);
+}
+
+int main() {
+    TestInline();
+    TestSpill();
+    TestCopyAndMove();
+    TestReserveAndSort();
+    return CheckFailures();
+}
@@ -0,0 +1,84 @@
+#include "../escapist/stack.h"
+#include "check.h"
+#include <string>
+
+static void TestStack() {
+    Stack<std::string> stack;
+    ESCAPIST_CHECK(stack.IsEmpty());
+    for (int i = 0; i < 100; ++i) {
+        stack.Push(std::to_string(i));
+    }
+    stack.Emplace(3, 'x');
+    ESCAPIST_CHECK(stack.Count() == 101);
+    ESCAPIST_CHECK(stack.Top() == "xxx");
+    ESCAPIST_CHECK(stack.Pop() == "xxx");
+    ESCAPIST_CHECK(stack.Pop() == "99");
+    stack.Discard(9);
+    ESCAPIST_CHECK(stack.Top() == "89");
+    const std::string range[] = {"a", "b"};
+    stack.PushRange(range, 2);
+    ESCAPIST_CHECK(stack.Count() == 92 && stack.Top() == "b");
+    ESCAPIST_CHECK(stack.ConstData()[0] == "0");
+    stack.Clear();
+    ESCAPIST_CHECK(stack.IsEmpty());
+}
+
+/**
+ * Pushing the top duplicates it, even when the push grows the block.
+ */
+static void TestPushTop() {
+    Stack<std::string> stack;
+    stack.Push("a string long enough to be kept on the heap by std::string");
+    bool same = true;
+    for (int i = 0; i < 100; ++i) {
+        SizeType count = stack.Count();
+        stack.Push(stack.Top());
+        stack.Emplace(stack.Top());
+        same = same && stack.Count() == count + 2 &&
+               stack.Top() == "a string long enough to be kept on the heap by std::string";
+    }
+    ESCAPIST_CHECK(same);
+    stack.Push(std::move(stack.Top()));
+    ESCAPIST_CHECK(stack.Top() == "a string long enough to be kept on the heap by std::string");
+}
+
+static void TestAssign() {
+    Stack<std::string> a, b;
+    for (int i = 0; i < 10; ++i) {
+        a.Push(std::to_string(i));
+    }
+    b.Push("old");
+    b = a;
+    ESCAPIST_CHECK(b.Count() == 10 && b.Top() == "9");
+    ESCAPIST_CHECK(b.ConstData() != a.ConstData());
+    b.Pop();
+    ESCAPIST_CHECK(a.Count() == 10 && a.Top() == "9");
+    b = b;
+    ESCAPIST_CHECK(b.Count() == 9 && b.Top() == "8");
+    Stack<std::string> c(a);
+    ESCAPIST_CHECK(c.Count() == 10 && c.ConstData() != a.ConstData());
+    c = std::move(b);
+    ESCAPIST_CHECK(c.Count() == 9 && b.IsEmpty());
+    Stack<std::string> d(std::move(c));
+    ESCAPIST_CHECK(d.Count() == 9 && c.IsEmpty());
+}
+
+static void TestInlineStack() {
+    InlineStack<std::string, 4> stack;
+    stack.Push("a").Push(std::string("b")).Emplace(2, 'c');
+    ESCAPIST_CHECK(stack.Count() == 3 && !stack.IsFull());
+    InlineStack<std::string, 4> copy(stack);
+    ESCAPIST_CHECK(copy.Pop() == "cc");
+    ESCAPIST_CHECK(stack.Top() == "cc");
+    copy.Push("d").Push("e");
+    ESCAPIST_CHECK(copy.IsFull());
+    ESCAPIST_CHECK(copy.Pop() == "e" && copy.Pop() == "d" && copy.Pop() == "b");
+}
+
+int main() {
+    TestStack();
+    TestPushTop();
+    TestAssign();
+    TestInlineStack();
+    return CheckFailures();
+}
@@ -0,0 +1,40 @@
+#include "../escapist/string_builder.h"
+#include "check.h"
+#include <string>
+
+using String = BasicString<char>;
+
+static void TestAppendPrepend() {
+    StringBuilder<char> builder;
+    ESCAPIST_CHECK(builder.IsEmpty());
+    builder.Append("world").Prepend("hello ").Append(BasicStringView<char>("!"));
+    ESCAPIST_CHECK(builder.Length() == 12);
+    ESCAPIST_CHECK(builder.ToString().Equals(BasicStringView<char>("hello world!")));
+}
+
+static void TestLargeChunks() {
+    StringBuilder<char> builder;
+    std::string expected;
+    String large(std::string(1000, 'x').c_str());
+    for (int i = 0; i < 50; ++i) {
+        builder.Append(large).Append("-");
+        expected += std::string(1000, 'x') + "-";
+    }
+    builder.Prepend(String(std::string(300, 'p').c_str()));
+    expected.insert(0, std::string(300, 'p'));
+    builder.Insert(1500, "<mid>");
+    expected.insert(1500, "<mid>");
+    builder.Insert(builder.Length(), String(std::string(400, 'e').c_str()));
+    expected += std::string(400, 'e');
+    ESCAPIST_CHECK(builder.ChunkCount() > 1);
+    ESCAPIST_CHECK(builder.Length() == expected.size());
+    ESCAPIST_CHECK(builder.ToString().Equals(BasicStringView<char>(expected.c_str())));
+    builder.Clear();
+    ESCAPIST_CHECK(builder.IsEmpty() && builder.ToString().IsEmpty());
+}
+
+int main() {
+    TestAppendPrepend();
+    TestLargeChunks();
+    return CheckFailures();
+}
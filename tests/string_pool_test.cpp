@@ -0,0 +1,60 @@
+#include "../escapist/string_pool.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+using String = BasicString<char>;
+
+static void TestIntern() {
+    StringPool<char> pool;
+    String a = pool.Intern(BasicStringView<char>("id")), b = pool.Intern(BasicStringView<char>("id"));
+    String c = pool.Intern(BasicStringView<char>("other"));
+    ESCAPIST_CHECK(StringPool<char>::Same(a, b));
+    ESCAPIST_CHECK(!StringPool<char>::Same(a, c));
+    ESCAPIST_CHECK(a.Equals(BasicStringView<char>("id")));
+    ESCAPIST_CHECK(pool.Count() == 2);
+    ESCAPIST_CHECK(StringPool<char>::Same(pool.Find(BasicStringView<char>("other")), c));
+    ESCAPIST_CHECK(pool.Find(BasicStringView<char>("missing")).IsEmpty());
+    ESCAPIST_CHECK(pool.Intern(BasicStringView<char>("")).IsEmpty());
+}
+
+static void TestRehash() {
+    StringPool<char, SingleThreadPolicy> pool;
+    std::vector<BasicString<char, SingleThreadPolicy>> interned;
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = "key" + std::to_string(i);
+        interned.push_back(pool.Intern(BasicStringView<char>(key.c_str())));
+    }
+    ESCAPIST_CHECK(pool.Count() == 1000);
+    bool same = true;
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = "key" + std::to_string(i);
+        same = same && StringPool<char, SingleThreadPolicy>::Same(
+                pool.Intern(BasicStringView<char>(key.c_str())), interned[i]);
+    }
+    ESCAPIST_CHECK(same);
+}
+
+static void TestConcurrentIntern() {
+    StringPool<char> pool;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool] {
+            for (int i = 0; i < 500; ++i) {
+                std::string key = "shared" + std::to_string(i);
+                pool.Intern(BasicStringView<char>(key.c_str()));
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    ESCAPIST_CHECK(pool.Count() == 500);
+}
+
+int main() {
+    TestIntern();
+    TestRehash();
+    TestConcurrentIntern();
+    return CheckFailures();
+}
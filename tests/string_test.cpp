@@ -0,0 +1,83 @@
+#include "../escapist/string.h"
+#include "check.h"
+
+using String = BasicString<char>;
+
+/**
+ * @return true if the characters of \p str are stored inside the instance
+ */
+static bool IsSmall(const String &str) {
+    const char *data = str.ConstData(), *self = reinterpret_cast<const char *>(&str);
+    return data >= self && data < self + sizeof(String);
+}
+
+/**
+ * Short strings live in the small buffer, whatever the way they are made.
+ */
+static void TestSmallBuffer() {
+    String hi("hi");
+    ESCAPIST_CHECK(IsSmall(hi) && hi.Capacity() < 64);
+    String copy(hi);
+    ESCAPIST_CHECK(IsSmall(copy) && copy.Equals(BasicStringView<char>("hi")));
+    String built;
+    built.Append("h").Append("i");
+    ESCAPIST_CHECK(IsSmall(built) && built.Equals(BasicStringView<char>("hi")));
+    String grown("h");
+    grown.Append("a string long enough to need a heap block of its own");
+    ESCAPIST_CHECK(!IsSmall(grown));
+}
+
+/**
+ * Detaching a short string from a shared heap block moves it into the small buffer.
+ */
+static void TestDetachShortSharedBlock() {
+    String x("a string long enough to live in a heap block");
+    x.Remove(2, x.Length() - 2); // short, still in its heap block.
+    String y(x);
+    y.At(0) = 'A';
+    ESCAPIST_CHECK(IsSmall(y) && !IsSmall(x));
+    ESCAPIST_CHECK(y.Equals(BasicStringView<char>("A ")) && x.Equals(BasicStringView<char>("a ")));
+    String z(x);
+    z.Data()[1] = '!';
+    ESCAPIST_CHECK(z.Equals(BasicStringView<char>("a!")) && x.Equals(BasicStringView<char>("a ")));
+    String front(x), middle(x);
+    front.Prepend("<");
+    middle.Insert(1, "-");
+    ESCAPIST_CHECK(front.Equals(BasicStringView<char>("<a ")) && middle.Equals(BasicStringView<char>("a- ")));
+    ESCAPIST_CHECK(x.Equals(BasicStringView<char>("a ")));
+}
+
+static void TestHash() {
+    String x("a string long enough to live in a heap block");
+    String equal("a string long enough to live in a heap block");
+    ESCAPIST_CHECK(x.Hash() == equal.Hash());
+    ESCAPIST_CHECK(x.Hash() == BasicStringView<char>(x).Hash());
+    String y(x);
+    ESCAPIST_CHECK(y.Hash() == x.Hash()); // cached in the shared block.
+    ESCAPIST_CHECK(y.ConstData() == x.ConstData());
+}
+
+/**
+ * A hash cached while the block was shared must not survive an in-place modification.
+ */
+static void TestHashAfterUnsharing() {
+    String x("a string long enough to live in a heap block");
+    {
+        String y(x);
+        y.Hash();
+    }
+    x.Append("!");
+    ESCAPIST_CHECK(x.Hash() == String("a string long enough to live in a heap block!").Hash());
+    x.ToUpper();
+    ESCAPIST_CHECK(x.Hash() == String("A STRING LONG ENOUGH TO LIVE IN A HEAP BLOCK!").Hash());
+    String z(x);
+    ESCAPIST_CHECK(z.Hash() == x.Hash());
+}
+
+int main() {
+    TestSmallBuffer();
+    TestDetachShortSharedBlock();
+    TestHash();
+    TestHashAfterUnsharing();
+    return CheckFailures();
+}
@@ -0,0 +1,63 @@
+#include "../escapist/time.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+static void TestClocks() {
+    std::int64_t start = MonotonicClock::Now();
+    std::uint64_t cycles = CycleClock::Now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ESCAPIST_CHECK(MonotonicClock::Now() - start >= 2000000);
+    ESCAPIST_CHECK(CycleClock::ToNanoseconds(CycleClock::Now() - cycles) >= 1000000);
+}
+
+static void TestHistogram() {
+    LatencyHistogram histogram;
+    ESCAPIST_CHECK(histogram.Count() == 0 && histogram.Percentile(0.5) == 0);
+    for (std::int64_t i = 1; i <= 1000; ++i) {
+        histogram.Record(i * 1000);
+    }
+    ESCAPIST_CHECK(histogram.Count() == 1000);
+    ESCAPIST_CHECK(histogram.Mean() == 500500.0);
+    std::uint64_t median = histogram.Percentile(0.5);
+    // buckets have a relative error of at most 1 / 2^kSubBits.
+    ESCAPIST_CHECK(median >= 500000 && median <= 500000 + 500000 / 8 + 1);
+    ESCAPIST_CHECK(histogram.Percentile(1) >= 1000000);
+    histogram.Reset();
+    ESCAPIST_CHECK(histogram.Count() == 0);
+}
+
+static void TestConcurrentRecord() {
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram] {
+            for (int i = 0; i < 10000; ++i) {
+                histogram.Record(i);
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    ESCAPIST_CHECK(histogram.Count() == 40000);
+}
+
+static void TestScopedTimer() {
+    LatencyHistogram histogram;
+    std::int64_t total = 0;
+    {
+        ScopedTimer into_histogram(histogram), into_total(total);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ESCAPIST_CHECK(histogram.Count() == 1);
+    ESCAPIST_CHECK(total >= 500000);
+}
+
+int main() {
+    TestClocks();
+    TestHistogram();
+    TestConcurrentRecord();
+    TestScopedTimer();
+    return CheckFailures();
+}